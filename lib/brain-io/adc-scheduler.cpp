@@ -0,0 +1,225 @@
+#include "brain-io/adc-scheduler.h"
+
+#include <hardware/adc.h>
+#include <hardware/gpio.h>
+#include <hardware/irq.h>
+#include <hardware/sync.h>
+
+#include <cstdio>
+
+namespace brain::io {
+
+static constexpr uint kAdcInputPots = 0;
+static constexpr uint kAdcRoundRobinMask = 0x07;  // ADC0, ADC1, ADC2
+static constexpr uint8_t kConversionsPerRound = 3;
+static constexpr uint32_t kAdcClockHz = 48000000;
+static constexpr uint32_t kAdcCyclesPerConversion = 96;
+
+// The ADC has a single FIFO interrupt, so only one scheduler can run
+static AdcScheduler* scheduler_instance = nullptr;
+
+bool AdcScheduler::init(uint8_t num_pot_channels, uint32_t round_rate_hz, uint s0_gpio,
+	uint s1_gpio) {
+	if (num_pot_channels == 0 || num_pot_channels > kMaxPotChannels) {
+		fprintf(stderr, "AdcScheduler: Invalid number of pot channels\n");
+		return false;
+	}
+
+	uint32_t max_round_rate = kAdcClockHz / (kAdcCyclesPerConversion * kConversionsPerRound);
+	if (round_rate_hz == 0 || round_rate_hz > max_round_rate) {
+		fprintf(stderr, "AdcScheduler: Round rate out of range\n");
+		return false;
+	}
+
+	if (scheduler_instance != nullptr && scheduler_instance != this) {
+		fprintf(stderr, "AdcScheduler: ADC is already scheduled\n");
+		return false;
+	}
+
+	if (running_) {
+		stop();
+	}
+
+	num_pot_channels_ = num_pot_channels;
+	for (uint8_t i = 0; i < kMaxPotChannels; i++) {
+		pot_channels_[i] = i;
+	}
+	s0_gpio_ = s0_gpio;
+	s1_gpio_ = s1_gpio;
+
+	gpio_init(s0_gpio_);
+	gpio_set_dir(s0_gpio_, GPIO_OUT);
+	gpio_init(s1_gpio_);
+	gpio_set_dir(s1_gpio_, GPIO_OUT);
+
+	scan_index_ = 0;
+	round_ = 0;
+	pot_sum_ = 0;
+	set_mux_channel(pot_channels_[scan_index_]);
+
+	adc_init();
+	adc_gpio_init(GPIO_BRAIN_POTMUX_ADC);
+	adc_gpio_init(GPIO_BRAIN_AUDIO_CV_IN_A);
+	adc_gpio_init(GPIO_BRAIN_AUDIO_CV_IN_B);
+
+	// Start at ADC0 so every group of three FIFO entries is pot, CV A, CV B
+	adc_select_input(kAdcInputPots);
+	adc_set_round_robin(kAdcRoundRobinMask);
+	adc_fifo_setup(true, false, kConversionsPerRound, false, false);
+	adc_fifo_drain();
+
+	uint32_t cycles = kAdcClockHz / (round_rate_hz * kConversionsPerRound);
+	adc_set_clkdiv(cycles > kAdcCyclesPerConversion ? static_cast<float>(cycles - 1) : 0.0f);
+
+	scheduler_instance = this;
+	running_ = true;
+
+	irq_set_exclusive_handler(ADC_IRQ_FIFO, &AdcScheduler::adc_irq_handler);
+	adc_irq_set_enabled(true);
+	irq_set_enabled(ADC_IRQ_FIFO, true);
+	adc_run(true);
+
+	return true;
+}
+
+void AdcScheduler::stop() {
+	if (!running_) {
+		return;
+	}
+
+	adc_run(false);
+	adc_irq_set_enabled(false);
+	irq_set_enabled(ADC_IRQ_FIFO, false);
+	irq_remove_handler(ADC_IRQ_FIFO, &AdcScheduler::adc_irq_handler);
+
+	adc_set_round_robin(0);
+	adc_fifo_setup(false, false, 0, false, false);
+	adc_fifo_drain();
+
+	running_ = false;
+	scheduler_instance = nullptr;
+}
+
+bool AdcScheduler::set_pot_channels(const uint8_t* mux_channels, uint8_t count) {
+	if (mux_channels == nullptr || count == 0 || count > kMaxPotChannels) {
+		fprintf(stderr, "AdcScheduler: Invalid number of pot channels\n");
+		return false;
+	}
+	for (uint8_t i = 0; i < count; i++) {
+		if (mux_channels[i] >= kMaxPotChannels) {
+			fprintf(stderr, "AdcScheduler: Mux channel %u out of range\n", mux_channels[i]);
+			return false;
+		}
+	}
+
+	// The interrupt walks the list, start the scan over with the new one
+	uint32_t irq_state = save_and_disable_interrupts();
+	for (uint8_t i = 0; i < count; i++) {
+		pot_channels_[i] = mux_channels[i];
+	}
+	num_pot_channels_ = count;
+	scan_index_ = 0;
+	round_ = 0;
+	pot_sum_ = 0;
+	set_mux_channel(pot_channels_[scan_index_]);
+	restore_interrupts(irq_state);
+
+	return true;
+}
+
+bool AdcScheduler::is_running() const {
+	return running_;
+}
+
+uint16_t AdcScheduler::get_pot_raw(uint8_t mux_channel) const {
+	if (mux_channel >= kMaxPotChannels) return 0;
+	return pot_raw_[mux_channel];
+}
+
+uint16_t AdcScheduler::get_cv_raw(uint8_t channel) const {
+	if (channel > 1) return 0;
+	return cv_raw_[channel];
+}
+
+uint32_t AdcScheduler::get_pot_cycle_count() const {
+	return pot_cycle_count_;
+}
+
+uint32_t AdcScheduler::get_restart_count() const {
+	return restart_count_;
+}
+
+void AdcScheduler::adc_irq_handler() {
+	AdcScheduler* self = scheduler_instance;
+	if (self == nullptr) {
+		adc_fifo_drain();
+		return;
+	}
+
+	// Once the 4-deep FIFO has overflowed, triples no longer start at ADC0
+	if (adc_hw->fcs & (ADC_FCS_OVER_BITS | ADC_FCS_UNDER_BITS)) {
+		self->restart();
+		return;
+	}
+
+	while (adc_fifo_get_level() >= kConversionsPerRound) {
+		uint16_t pot = adc_fifo_get();
+		uint16_t cv_a = adc_fifo_get();
+		uint16_t cv_b = adc_fifo_get();
+		self->handle_round(pot, cv_a, cv_b);
+	}
+}
+
+/**
+ * Runs in the interrupt after a FIFO overflow, e.g. when other interrupts
+ * held it off for more than a round. The current pot starts settling again.
+ */
+void AdcScheduler::restart() {
+	adc_run(false);
+
+	// Let a conversion in flight land before draining it
+	while (!(adc_hw->cs & ADC_CS_READY_BITS)) {
+	}
+	adc_fifo_drain();
+	adc_hw->fcs |= ADC_FCS_OVER_BITS | ADC_FCS_UNDER_BITS;
+
+	adc_select_input(kAdcInputPots);
+	adc_set_round_robin(kAdcRoundRobinMask);
+	round_ = 0;
+	pot_sum_ = 0;
+	restart_count_ = restart_count_ + 1;
+
+	adc_run(true);
+}
+
+void AdcScheduler::handle_round(uint16_t pot, uint16_t cv_a, uint16_t cv_b) {
+	cv_raw_[0] = cv_a;
+	cv_raw_[1] = cv_b;
+
+	// Rounds right after a mux change only give the mux time to settle
+	if (round_ >= kSettleRounds) {
+		pot_sum_ += pot;
+	}
+
+	if (++round_ < kSettleRounds + kSampleRounds) {
+		return;
+	}
+
+	pot_raw_[pot_channels_[scan_index_]] = static_cast<uint16_t>(pot_sum_ / kSampleRounds);
+	pot_sum_ = 0;
+	round_ = 0;
+
+	if (++scan_index_ >= num_pot_channels_) {
+		scan_index_ = 0;
+		pot_cycle_count_ = pot_cycle_count_ + 1;
+	}
+	set_mux_channel(pot_channels_[scan_index_]);
+}
+
+void AdcScheduler::set_mux_channel(uint8_t ch) {
+	ch &= 0x03;
+	gpio_put(s0_gpio_, ch & 0x01);
+	gpio_put(s1_gpio_, (ch >> 1) & 0x01);
+}
+
+}  // namespace brain::io
@@ -1,14 +1,29 @@
 #include "brain-io/audio-cv-in.h"
 
+#include <hardware/dma.h>
 #include <hardware/gpio.h>
+#include <hardware/irq.h>
+#include <hardware/sync.h>
 #include <pico/stdlib.h>
 
 #include <cstdio>
 
+#include "brain-io/adc-scheduler.h"
+
 namespace brain::io {
 
 using namespace brain::constants;
 
+// ADC inputs used by the two channels, and the ADC clock they share
+static constexpr uint kAdcInputChannelA = 1;
+static constexpr uint kAdcInputChannelB = 2;
+static constexpr uint kAdcRoundRobinMask = (1u << kAdcInputChannelA) | (1u << kAdcInputChannelB);
+static constexpr uint32_t kAdcClockHz = 48000000;
+static constexpr uint32_t kAdcCyclesPerConversion = 96;
+
+// Only one instance can own the ADC stream at a time
+static AudioCvIn* stream_instance = nullptr;
+
 bool AudioCvIn::init() {
 	// Initialize ADC hardware
 	adc_init();
@@ -26,7 +41,36 @@ bool AudioCvIn::init() {
 	return true;
 }
 
+bool AudioCvIn::init(AdcScheduler* scheduler) {
+	if (scheduler == nullptr) {
+		return false;
+	}
+
+	// The scheduler has already set up the ADC, don't reset it here
+	scheduler_ = scheduler;
+	calculate_conversion_parameters();
+	update();
+
+	return true;
+}
+
 void AudioCvIn::update() {
+	// Readings are refreshed from the DMA interrupt while streaming
+	if (streaming_) {
+		return;
+	}
+
+	// Readings are published by the scheduler, no ADC access
+	if (scheduler_ != nullptr) {
+		channel_raw_[AudioCvInChannel::kChannelA] = scheduler_->get_cv_raw(0);
+		channel_raw_[AudioCvInChannel::kChannelB] = scheduler_->get_cv_raw(1);
+		return;
+	}
+
+	// sample_raw() may run from an interrupt, keep it from switching the
+	// input between select and read
+	uint32_t irq_state = save_and_disable_interrupts();
+
 	// Read channel A (GPIO 27 = ADC1)
 	adc_select_input(1);
 	channel_raw_[AudioCvInChannel::kChannelA] = adc_read();
@@ -34,10 +78,340 @@ void AudioCvIn::update() {
 	// Read channel B (GPIO 28 = ADC2)
 	adc_select_input(2);
 	channel_raw_[AudioCvInChannel::kChannelB] = adc_read();
+
+	restore_interrupts(irq_state);
+}
+
+/**
+ * While streaming, the busy DMA channel's remaining transfer count says how
+ * far its buffer is filled. Samples are interleaved A, B, so the channel's
+ * newest sample is the last entry of its parity below that point, or the end
+ * of the other buffer when the current one doesn't hold one yet.
+ */
+uint16_t AudioCvIn::sample_raw(int channel) {
+	if (!is_valid_channel(channel)) {
+		return 0;
+	}
+
+	if (scheduler_ != nullptr) {
+		channel_raw_[channel] = scheduler_->get_cv_raw(static_cast<uint8_t>(channel));
+		return channel_raw_[channel];
+	}
+
+	if (streaming_) {
+		for (uint8_t i = 0; i < 2; i++) {
+			uint dma = static_cast<uint>(dma_channel_[i]);
+			if (!dma_channel_is_busy(dma)) {
+				continue;
+			}
+
+			uint32_t written = kStreamBlockSize * 2 - dma_channel_hw_addr(dma)->transfer_count;
+			uint32_t c = static_cast<uint32_t>(channel);
+			if (written > c) {
+				return stream_buffer_[i][((written - 1 - c) & ~1u) + c];
+			}
+			return stream_buffer_[i ^ 1][kStreamBlockSize * 2 - 2 + c];
+		}
+		return channel_raw_[channel];
+	}
+
+	// Put the previous input back: an interrupted pot read may be settling on it
+	uint input = channel == AudioCvInChannel::kChannelA ? kAdcInputChannelA : kAdcInputChannelB;
+	uint32_t irq_state = save_and_disable_interrupts();
+	uint previous = adc_get_selected_input();
+	adc_select_input(input);
+	uint16_t raw = adc_read();
+	adc_select_input(previous);
+	restore_interrupts(irq_state);
+
+	channel_raw_[channel] = raw;
+	return raw;
+}
+
+bool AudioCvIn::start_stream(uint32_t sample_rate_hz, ProcessCallback process) {
+	if (sample_rate_hz == 0 || sample_rate_hz > kMaxStreamSampleRate) {
+		fprintf(stderr, "AudioCvIn: Stream rate %lu Hz out of range\n",
+			static_cast<unsigned long>(sample_rate_hz));
+		return false;
+	}
+
+	if (scheduler_ != nullptr) {
+		fprintf(stderr, "AudioCvIn: ADC is owned by a scheduler\n");
+		return false;
+	}
+
+	if (stream_instance != nullptr && stream_instance != this) {
+		fprintf(stderr, "AudioCvIn: ADC is already streaming\n");
+		return false;
+	}
+
+	if (streaming_) {
+		stop_stream();
+	}
+
+	for (int i = 0; i < 2; i++) {
+		dma_channel_[i] = dma_claim_unused_channel(false);
+		if (dma_channel_[i] < 0) {
+			fprintf(stderr, "AudioCvIn: No free DMA channel\n");
+			if (i == 1) dma_channel_unclaim(dma_channel_[0]);
+			dma_channel_[0] = -1;
+			dma_channel_[1] = -1;
+			return false;
+		}
+	}
+
+	process_ = process;
+	stream_sample_rate_ = sample_rate_hz;
+	sample_period_ns_ = 1000000000u / sample_rate_hz;
+
+	// Free-running round-robin over ADC1/ADC2, starting at channel A so the
+	// buffers are interleaved A, B, A, B, ...
+	adc_run(false);
+	adc_select_input(kAdcInputChannelA);
+	adc_set_round_robin(kAdcRoundRobinMask);
+	adc_fifo_setup(true, true, 1, false, false);
+	adc_fifo_drain();
+
+	// One conversion every (1 + div) ADC clocks, two conversions per sample pair
+	uint32_t cycles = kAdcClockHz / (sample_rate_hz * 2);
+	adc_set_clkdiv(cycles > kAdcCyclesPerConversion ? static_cast<float>(cycles - 1) : 0.0f);
+
+	// Each channel fills one buffer and then triggers the other
+	for (int i = 0; i < 2; i++) {
+		uint channel = static_cast<uint>(dma_channel_[i]);
+		dma_channel_config config = dma_channel_get_default_config(channel);
+		channel_config_set_transfer_data_size(&config, DMA_SIZE_16);
+		channel_config_set_read_increment(&config, false);
+		channel_config_set_write_increment(&config, true);
+		channel_config_set_dreq(&config, DREQ_ADC);
+		channel_config_set_chain_to(&config, static_cast<uint>(dma_channel_[i ^ 1]));
+		dma_channel_configure(channel, &config, stream_buffer_[i], &adc_hw->fifo,
+			kStreamBlockSize * 2, false);
+		dma_channel_set_irq0_enabled(channel, true);
+	}
+
+	stream_instance = this;
+	streaming_ = true;
+	irq_add_shared_handler(
+		DMA_IRQ_0, &AudioCvIn::dma_irq_handler, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+	irq_set_enabled(DMA_IRQ_0, true);
+
+	dma_channel_start(static_cast<uint>(dma_channel_[0]));
+	adc_run(true);
+
+	return true;
+}
+
+void AudioCvIn::stop_stream() {
+	if (!streaming_) {
+		return;
+	}
+
+	// Stop conversions first so neither channel sees another DREQ
+	adc_run(false);
+
+	for (int i = 0; i < 2; i++) {
+		uint channel = static_cast<uint>(dma_channel_[i]);
+		dma_channel_set_irq0_enabled(channel, false);
+		dma_channel_abort(channel);
+		dma_channel_acknowledge_irq0(channel);
+		dma_channel_unclaim(channel);
+		dma_channel_[i] = -1;
+	}
+
+	irq_remove_handler(DMA_IRQ_0, &AudioCvIn::dma_irq_handler);
+
+	adc_set_round_robin(0);
+	adc_fifo_setup(false, false, 0, false, false);
+	adc_fifo_drain();
+
+	streaming_ = false;
+	stream_sample_rate_ = 0;
+	stream_instance = nullptr;
+}
+
+bool AudioCvIn::is_streaming() const {
+	return streaming_;
+}
+
+uint32_t AudioCvIn::get_stream_sample_rate() const {
+	return stream_sample_rate_;
+}
+
+void AudioCvIn::dma_irq_handler() {
+	AudioCvIn* self = stream_instance;
+	if (self == nullptr) {
+		return;
+	}
+
+	uint32_t now = time_us_32();
+
+	for (uint8_t i = 0; i < 2; i++) {
+		uint channel = static_cast<uint>(self->dma_channel_[i]);
+		if (dma_channel_get_irq0_status(channel)) {
+			dma_channel_acknowledge_irq0(channel);
+
+			// Re-arm for the next round; the transfer count reloads by itself
+			dma_channel_set_write_addr(channel, self->stream_buffer_[i], false);
+			self->handle_block(i, now);
+		}
+	}
+}
+
+void AudioCvIn::handle_block(uint8_t buffer_index, uint32_t block_end_us) {
+	const uint16_t* interleaved = stream_buffer_[buffer_index];
+
+	for (size_t i = 0; i < kStreamBlockSize; i++) {
+		block_a_[i] = interleaved[i * 2];
+		block_b_[i] = interleaved[i * 2 + 1];
+	}
+
+	channel_raw_[AudioCvInChannel::kChannelA] = block_a_[kStreamBlockSize - 1];
+	channel_raw_[AudioCvInChannel::kChannelB] = block_b_[kStreamBlockSize - 1];
+
+	if (oversampling_log2_ > 0) {
+		decimator_[AudioCvInChannel::kChannelA].process(block_a_, kStreamBlockSize, nullptr);
+		decimator_[AudioCvInChannel::kChannelB].process(block_b_, kStreamBlockSize, nullptr);
+	}
+
+	if (edge_detection_[AudioCvInChannel::kChannelA]) {
+		detect_edges(AudioCvInChannel::kChannelA, block_a_, block_end_us);
+	}
+	if (edge_detection_[AudioCvInChannel::kChannelB]) {
+		detect_edges(AudioCvInChannel::kChannelB, block_b_, block_end_us);
+	}
+
+	if (process_) {
+		process_(block_a_, block_b_, kStreamBlockSize);
+	}
+}
+
+/**
+ * The last sample of the block was converted just before the DMA interrupt,
+ * earlier samples are one sample period apart. Timestamps are exact to one
+ * sample plus the (constant) interrupt latency.
+ */
+void AudioCvIn::detect_edges(int channel, const uint16_t* block, uint32_t block_end_us) {
+	brain::utils::SchmittTrigger::Edge edges[kEdgeQueueSize];
+	size_t count =
+		edge_detector_[channel].process(block, kStreamBlockSize, edges, kEdgeQueueSize);
+
+	for (size_t i = 0; i < count; i++) {
+		uint8_t next = (edge_head_ + 1) & (kEdgeQueueSize - 1);
+		if (next == edge_tail_) {
+			// Queue full, drop newest
+			return;
+		}
+
+		uint64_t samples_before_end = kStreamBlockSize - 1 - edges[i].index;
+		uint32_t offset_us = static_cast<uint32_t>(samples_before_end * sample_period_ns_ / 1000);
+
+		AudioCvInEdge& edge = edge_queue_[edge_head_];
+		edge.channel = static_cast<uint8_t>(channel);
+		edge.rising = edges[i].rising;
+		edge.time_us = block_end_us - offset_us;
+		edge_head_ = next;
+	}
+}
+
+bool AudioCvIn::set_edge_thresholds(int channel, int32_t low_mv, int32_t high_mv) {
+	if (!is_valid_channel(channel) || low_mv >= high_mv) {
+		return false;
+	}
+
+	// Keep the stream interrupt away from the detector while it's reconfigured
+	edge_detection_[channel] = false;
+
+	uint16_t low = millivolts_to_raw(channel, low_mv);
+	uint16_t high = millivolts_to_raw(channel, high_mv);
+	if (!edge_detector_[channel].set_thresholds(low, high)) {
+		return false;
+	}
+
+	// Start from the current level so enabling doesn't report a false edge
+	edge_detector_[channel].reset(channel_raw_[channel] >= high);
+	edge_detection_[channel] = true;
+	return true;
+}
+
+void AudioCvIn::disable_edge_detection(int channel) {
+	if (is_valid_channel(channel)) {
+		edge_detection_[channel] = false;
+	}
+}
+
+bool AudioCvIn::read_edge(AudioCvInEdge& edge) {
+	if (edge_tail_ == edge_head_) {
+		return false;
+	}
+
+	edge = edge_queue_[edge_tail_];
+	edge_tail_ = (edge_tail_ + 1) & (kEdgeQueueSize - 1);
+	return true;
+}
+
+uint16_t AudioCvIn::millivolts_to_raw(int channel, int32_t millivolts) const {
+	const AudioCvInCalibration& cal = calibration_[channel & 1];
+	if (cal.gain_q16 <= 0) {
+		return 0;
+	}
+
+	// Multiply instead of shifting, the difference can be negative
+	int64_t raw = (static_cast<int64_t>(millivolts) - cal.offset_mv) * 65536 / cal.gain_q16;
+	if (raw < 0) return 0;
+	if (raw > kAdcMaxValue) return kAdcMaxValue;
+	return static_cast<uint16_t>(raw);
+}
+
+bool AudioCvIn::set_oversampling(uint8_t decimation_log2) {
+	if (decimation_log2 == 0) {
+		oversampling_log2_ = 0;
+		return true;
+	}
+
+	if (decimation_log2 > brain::utils::CicDecimator::kMaxDecimationLog2) {
+		return false;
+	}
+
+	// Keep the stream interrupt away from the decimators while they reset
+	oversampling_log2_ = 0;
+	decimator_[AudioCvInChannel::kChannelA].init(decimation_log2);
+	decimator_[AudioCvInChannel::kChannelB].init(decimation_log2);
+	oversampling_log2_ = decimation_log2;
+	return true;
+}
+
+uint16_t AudioCvIn::get_raw_hires(int channel) const {
+	if (!is_valid_channel(channel)) {
+		return 0;
+	}
+
+	if (!streaming_ || oversampling_log2_ == 0) {
+		return channel_raw_[channel] << 4;
+	}
+	return decimator_[channel].value();
+}
+
+int32_t AudioCvIn::get_microvolts_hires(int channel) const {
+	if (!is_valid_channel(channel)) {
+		return 0;
+	}
+
+	// Gain is per 12-bit step and the reading is on the raw * 16 scale
+	const AudioCvInCalibration& cal = calibration_[channel];
+	int64_t scaled = static_cast<int64_t>(get_raw_hires(channel)) * cal.gain_q16 * 1000;
+	return static_cast<int32_t>(scaled >> 20) + cal.offset_mv * 1000;
+}
+
+uint32_t AudioCvIn::get_hires_sample_rate() const {
+	if (!streaming_ || oversampling_log2_ == 0) {
+		return 0;
+	}
+	return stream_sample_rate_ >> oversampling_log2_;
 }
 
 uint16_t AudioCvIn::get_raw(int channel) const {
-	if (channel == AudioCvInChannel::kChannelA || channel == AudioCvInChannel::kChannelB) {
+	if (is_valid_channel(channel)) {
 		return channel_raw_[channel];
 	}
 	return 0;
@@ -52,41 +426,140 @@ uint16_t AudioCvIn::get_raw_channel_b() const {
 }
 
 float AudioCvIn::get_voltage(int channel) const {
-	if (channel == AudioCvInChannel::kChannelA || channel == AudioCvInChannel::kChannelB) {
-		return adc_to_voltage(channel_raw_[channel]);
+	if (is_valid_channel(channel)) {
+		return adc_to_voltage(channel, channel_raw_[channel]);
 	}
 	return 0.0f;
 }
 
 float AudioCvIn::get_voltage_channel_a() const {
-	return adc_to_voltage(channel_raw_[AudioCvInChannel::kChannelA]);
+	return adc_to_voltage(AudioCvInChannel::kChannelA, channel_raw_[AudioCvInChannel::kChannelA]);
 }
 
 float AudioCvIn::get_voltage_channel_b() const {
-	return adc_to_voltage(channel_raw_[AudioCvInChannel::kChannelB]);
+	return adc_to_voltage(AudioCvInChannel::kChannelB, channel_raw_[AudioCvInChannel::kChannelB]);
 }
 
-float AudioCvIn::adc_to_voltage(uint16_t adc_value) const {
-	// Convert ADC reading to voltage
-	float adc_voltage = (static_cast<float>(adc_value) / kAdcMaxValue) * kAdcVoltageRef;
+int32_t AudioCvIn::get_millivolts(int channel) const {
+	if (is_valid_channel(channel)) {
+		return raw_to_millivolts(channel, channel_raw_[channel]);
+	}
+	return 0;
+}
 
-	// Apply calibration to get original signal voltage
-	return (adc_voltage * voltage_scale_) + voltage_offset_;
+int16_t AudioCvIn::get_q15(int channel) const {
+	if (!is_valid_channel(channel)) {
+		return 0;
+	}
+
+	// 32767 / 5000 mV as Q12
+	int32_t q15 = (get_millivolts(channel) * 26844) >> 12;
+	if (q15 > 32767) return 32767;
+	if (q15 < -32768) return -32768;
+	return static_cast<int16_t>(q15);
+}
+
+int32_t AudioCvIn::raw_to_millivolts(int channel, uint16_t raw) const {
+	const AudioCvInCalibration& cal = calibration_[channel & 1];
+	return ((static_cast<int32_t>(raw) * cal.gain_q16) >> 16) + cal.offset_mv;
+}
+
+void AudioCvIn::convert_block_mv(int channel, const uint16_t* raw, int16_t* out_mv,
+	size_t n) const {
+	if (!is_valid_channel(channel)) {
+		return;
+	}
+
+	const int16_t* table = lookup_table_[channel];
+	if (table != nullptr) {
+		for (size_t i = 0; i < n; i++) {
+			out_mv[i] = table[raw[i] & (kLookupTableSize - 1)];
+		}
+		return;
+	}
+
+	const int32_t gain = calibration_[channel].gain_q16;
+	const int32_t offset = calibration_[channel].offset_mv;
+	for (size_t i = 0; i < n; i++) {
+		out_mv[i] = static_cast<int16_t>(((static_cast<int32_t>(raw[i]) * gain) >> 16) + offset);
+	}
+}
+
+void AudioCvIn::set_calibration(int channel, const AudioCvInCalibration& calibration) {
+	if (!is_valid_channel(channel)) {
+		return;
+	}
+
+	calibration_[channel] = calibration;
+	build_lookup_table(channel);
+}
+
+bool AudioCvIn::set_calibration_points(int channel, uint16_t raw_at_minus_5v,
+	uint16_t raw_at_plus_5v) {
+	if (!is_valid_channel(channel) || raw_at_plus_5v <= raw_at_minus_5v) {
+		return false;
+	}
+
+	int32_t min_mv = static_cast<int32_t>(kAudioCvInMinVoltage * 1000);
+	int32_t span_mv = static_cast<int32_t>(kAudioCvInMaxVoltage * 1000) - min_mv;
+
+	AudioCvInCalibration calibration;
+	calibration.gain_q16 = (span_mv << 16) / (raw_at_plus_5v - raw_at_minus_5v);
+	calibration.offset_mv =
+		min_mv - ((static_cast<int32_t>(raw_at_minus_5v) * calibration.gain_q16) >> 16);
+
+	set_calibration(channel, calibration);
+	return true;
+}
+
+AudioCvInCalibration AudioCvIn::get_calibration(int channel) const {
+	return calibration_[is_valid_channel(channel) ? channel : AudioCvInChannel::kChannelA];
+}
+
+void AudioCvIn::set_lookup_table(int channel, int16_t* table) {
+	if (!is_valid_channel(channel)) {
+		return;
+	}
+
+	lookup_table_[channel] = table;
+	build_lookup_table(channel);
+}
+
+void AudioCvIn::build_lookup_table(int channel) {
+	int16_t* table = lookup_table_[channel];
+	if (table == nullptr) {
+		return;
+	}
+
+	for (size_t raw = 0; raw < kLookupTableSize; raw++) {
+		table[raw] = static_cast<int16_t>(raw_to_millivolts(channel, static_cast<uint16_t>(raw)));
+	}
+}
+
+float AudioCvIn::adc_to_voltage(int channel, uint16_t adc_value) const {
+	return raw_to_millivolts(channel, adc_value) * 0.001f;
 }
 
 void AudioCvIn::calculate_conversion_parameters() {
 	// Calculate linear conversion from measured ADC voltages to original signal voltages
 	// Two known points: (kAudioCvInVoltageAtMinus5V, kAudioCvInMinVoltage)
 	//                   (kAudioCvInVoltageAtPlus5V, kAudioCvInMaxVoltage)
+	// Done once in float, conversions afterwards are integer only
+
+	float raw_at_minus = kAudioCvInVoltageAtMinus5V / kAdcVoltageRef * kAdcMaxValue;
+	float raw_at_plus = kAudioCvInVoltageAtPlus5V / kAdcVoltageRef * kAdcMaxValue;
 
-	float voltage_span = kAudioCvInVoltageAtPlus5V - kAudioCvInVoltageAtMinus5V;
-	float signal_span = kAudioCvInMaxVoltage - kAudioCvInMinVoltage;
+	// Millivolts per ADC step
+	float span_mv = (kAudioCvInMaxVoltage - kAudioCvInMinVoltage) * 1000.0f;
+	float gain = span_mv / (raw_at_plus - raw_at_minus);
 
-	// Scale factor: change in output per unit change in input
-	voltage_scale_ = signal_span / voltage_span;
+	AudioCvInCalibration calibration;
+	calibration.gain_q16 = static_cast<int32_t>(gain * 65536.0f + 0.5f);
+	calibration.offset_mv =
+		static_cast<int32_t>(kAudioCvInMinVoltage * 1000.0f - raw_at_minus * gain);
 
-	// Offset: output value when input is zero
-	voltage_offset_ = kAudioCvInMinVoltage - (kAudioCvInVoltageAtMinus5V * voltage_scale_);
+	set_calibration(AudioCvInChannel::kChannelA, calibration);
+	set_calibration(AudioCvInChannel::kChannelB, calibration);
 }
 
-}  // namespace brain::io
\ No newline at end of file
+}  // namespace brain::io
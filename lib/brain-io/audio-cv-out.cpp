@@ -1,6 +1,7 @@
 #include "brain-io/audio-cv-out.h"
 
 #include <hardware/gpio.h>
+#include <hardware/sync.h>
 #include <pico/stdlib.h>
 
 #include <cstdio>
@@ -61,6 +62,43 @@ bool AudioCvOut::set_voltage(AudioCvOutChannel channel, float voltage) {
 	return true;
 }
 
+bool AudioCvOut::set_dac_value(AudioCvOutChannel channel, uint16_t dac_value) {
+	if (dac_value > kMaxDacValue) {
+		dac_value = kMaxDacValue;
+	}
+
+	write_dac_channel(channel, dac_value);
+	return true;
+}
+
+bool AudioCvOut::set_dac_values(uint16_t dac_value_a, uint16_t dac_value_b) {
+	if (dac_value_a > kMaxDacValue) {
+		dac_value_a = kMaxDacValue;
+	}
+	if (dac_value_b > kMaxDacValue) {
+		dac_value_b = kMaxDacValue;
+	}
+
+	// The MCP4822 latches each channel on its own CS edge, so the pair is two
+	// frames; keeping interrupts off makes them land ~35us apart, uninterrupted
+	uint32_t irq_state = save_and_disable_interrupts();
+	write_dac_channel(AudioCvOutChannel::kChannelA, dac_value_a);
+	write_dac_channel(AudioCvOutChannel::kChannelB, dac_value_b);
+	restore_interrupts(irq_state);
+	return true;
+}
+
+bool AudioCvOut::set_voltages(float voltage_a, float voltage_b) {
+	if (voltage_a < 0.0f || voltage_a > kMaxVoltage || voltage_b < 0.0f ||
+		voltage_b > kMaxVoltage) {
+		fprintf(stderr, "AudioCvOut: Voltage pair %.2fV/%.2fV out of range (0-%.1fV)\n", voltage_a,
+			voltage_b, kMaxVoltage);
+		return false;
+	}
+
+	return set_dac_values(voltage_to_dac(voltage_a), voltage_to_dac(voltage_b));
+}
+
 bool AudioCvOut::set_coupling(AudioCvOutChannel channel, AudioCvOutCoupling coupling) {
 	uint coupling_pin =
 		(channel == AudioCvOutChannel::kChannelA) ? coupling_pin_a_ : coupling_pin_b_;
@@ -83,7 +121,9 @@ void AudioCvOut::write_dac_channel(AudioCvOutChannel channel, uint16_t dac_value
 	// Get lo-byte
 	data[1] = dac_value & 0xff;
 
-	// Send command via SPI
+	// Send command via SPI. Interrupts stay off for the ~17us frame, so a write
+	// from an interrupt handler can't land inside one from the main loop
+	uint32_t irq_state = save_and_disable_interrupts();
 	asm volatile("nop \n nop \n nop");
 	gpio_put(cs_pin_, 0);  // Assert CS
 	asm volatile("nop \n nop \n nop");
@@ -93,6 +133,7 @@ void AudioCvOut::write_dac_channel(AudioCvOutChannel channel, uint16_t dac_value
 	asm volatile("nop \n nop \n nop");
 	gpio_put(cs_pin_, 1);  // Deassert CS
 	asm volatile("nop \n nop \n nop");
+	restore_interrupts(irq_state);
 }
 
 uint16_t AudioCvOut::voltage_to_dac(float voltage) {
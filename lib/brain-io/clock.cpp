@@ -0,0 +1,267 @@
+// Implementation of Clock: input period tracking and alarm-driven output clocks.
+// Input edges arrive via Pulse callbacks, output ticks run in the alarm interrupt.
+
+#include "brain-io/clock.h"
+
+#include "brain-common/brain-common.h"
+#include "hardware/timer.h"
+
+namespace brain::io {
+
+static bool within_tolerance(uint32_t interval, uint32_t reference) {
+	uint32_t tolerance = reference / 100 * Clock::kOutlierPercent;
+	return interval + tolerance >= reference && interval <= reference + tolerance;
+}
+
+Clock::~Clock() {
+	cancel();
+}
+
+bool Clock::init(Pulse* pulse) {
+	if (pulse == nullptr) {
+		return false;
+	}
+
+	pulse_ = pulse;
+	pulse_->on_rise_timed([this](uint32_t time_us) { handle_input(time_us); });
+	pulse_->enable_interrupts();
+	stop();
+
+	return true;
+}
+
+void Clock::set_multiplier(uint8_t multiplier) {
+	if (multiplier == 0 || multiplier > kMaxRatio) return;
+	multiplier_ = multiplier;
+}
+
+void Clock::set_divider(uint8_t divider) {
+	if (divider == 0 || divider > kMaxRatio) return;
+	divider_ = divider;
+	input_count_ = 0;
+}
+
+void Clock::set_swing(uint8_t percent) {
+	if (percent < kMinSwing) percent = kMinSwing;
+	if (percent > kMaxSwing) percent = kMaxSwing;
+	swing_ = percent;
+}
+
+void Clock::set_pulse_width_us(uint32_t us) {
+	pulse_width_us_ = us;
+}
+
+void Clock::set_input_ppqn(uint8_t ppqn) {
+	input_ppqn_ = ppqn > 0 ? ppqn : 1;
+}
+
+void Clock::update() {
+	if (!has_edge_ || period_us_ == 0) return;
+
+	// Input stopped, don't keep extrapolating the old tempo
+	if (time_us_32() - last_raw_edge_us_ > period_us_ * kTimeoutPeriods) {
+		stop();
+	}
+}
+
+void Clock::stop() {
+	cancel();
+	if (pulse_ != nullptr && output_high_) {
+		pulse_->set(false);
+	}
+	output_high_ = false;
+	locked_ = false;
+
+	history_count_ = 0;
+	history_pos_ = 0;
+	outliers_ = 0;
+	period_us_ = 0;
+	has_edge_ = false;
+	input_count_ = 0;
+}
+
+uint32_t Clock::get_period_us() const {
+	return period_us_;
+}
+
+float Clock::get_bpm() const {
+	if (period_us_ == 0) return 0.0f;
+	float quarter_us = static_cast<float>(period_us_) * input_ppqn_;
+	return 60.0f * brain::constants::kMicrosPerSecond / quarter_us;
+}
+
+bool Clock::is_locked() const {
+	return locked_;
+}
+
+void Clock::push_interval(uint32_t interval) {
+	history_[history_pos_] = interval;
+	history_pos_ = (history_pos_ + 1) % kHistorySize;
+	if (history_count_ < kHistorySize) history_count_++;
+
+	uint32_t sum = 0;
+	for (uint8_t i = 0; i < history_count_; i++) {
+		sum += history_[i];
+	}
+	period_us_ = sum / history_count_;
+}
+
+/**
+ * Classifies an edge against the period estimate. Returns true if it counts
+ * as a beat. A beat on the grid always counts, extra edges (glitches) are
+ * dropped, late edges (missed pulses) still count but don't change the
+ * period. Only outliers that repeat with a consistent interval are taken as
+ * a new tempo, so a single stray edge in the middle of a period can't halve
+ * it. A faster tempo puts every other edge on the grid, those keep the
+ * streak going instead of clearing it.
+ */
+bool Clock::update_period(uint32_t time_us) {
+	uint32_t raw_interval = time_us - last_raw_edge_us_;
+	uint32_t beat_interval = time_us - last_edge_us_;
+	last_raw_edge_us_ = time_us;
+
+	if (period_us_ == 0) {
+		push_interval(raw_interval);
+		return true;
+	}
+
+	bool repeated = outliers_ > 0 && !within_tolerance(raw_interval, period_us_) &&
+		within_tolerance(raw_interval, last_outlier_us_);
+	if (repeated) {
+		last_outlier_us_ = raw_interval;
+		if (++outliers_ >= kMaxOutliers) {
+			history_count_ = 0;
+			history_pos_ = 0;
+			outliers_ = 0;
+			push_interval(raw_interval);
+			return true;
+		}
+	}
+
+	if (within_tolerance(beat_interval, period_us_)) {
+		if (!repeated) outliers_ = 0;
+		push_interval(beat_interval);
+		return true;
+	}
+
+	if (!repeated) {
+		outliers_ = 1;
+		last_outlier_us_ = raw_interval;
+	}
+	return beat_interval > period_us_;
+}
+
+void Clock::handle_input(uint32_t time_us) {
+	if (!has_edge_) {
+		has_edge_ = true;
+		last_edge_us_ = time_us;
+		last_raw_edge_us_ = time_us;
+		return;
+	}
+
+	if (!update_period(time_us)) {
+		return;
+	}
+	last_edge_us_ = time_us;
+
+	// Only the first beat of every divider_ beats starts a cycle
+	bool cycle_start = input_count_ == 0;
+	input_count_ = (input_count_ + 1) % divider_;
+	if (!cycle_start) {
+		return;
+	}
+
+	// Nothing may fire while the schedule moves
+	cancel();
+
+	uint64_t edge_us = time_us_64() - static_cast<uint32_t>(time_us_32() - time_us);
+	cycle_us_ = period_us_ * divider_;
+
+	int64_t since_anchor = static_cast<int64_t>(edge_us - anchor_us_);
+	bool tick0_fired = locked_ && next_tick_ > 0 && next_tick_ <= multiplier_ &&
+		since_anchor > -static_cast<int64_t>(cycle_us_ / 2) && since_anchor < cycle_us_ / 2;
+
+	locked_ = true;
+	anchor_us_ = edge_us;
+
+	if (tick0_fired) {
+		// The prediction was close, keep going from the exact input phase
+		schedule(output_high_ ? alarm_target_us_ : tick_time(next_tick_));
+	} else {
+		// Input came before the predicted tick 0, drop the rest of the old cycle
+		next_tick_ = 0;
+		if (output_high_) {
+			pulse_->set(false);
+			output_high_ = false;
+		}
+		schedule(edge_us);
+	}
+}
+
+uint32_t Clock::tick_step_us() const {
+	return cycle_us_ / multiplier_;
+}
+
+uint64_t Clock::tick_time(uint8_t index) const {
+	if (index >= multiplier_) {
+		return anchor_us_ + cycle_us_;
+	}
+
+	// Ticks come in pairs, swing moves the second one later within the pair
+	uint64_t pair = static_cast<uint64_t>(tick_step_us()) * 2;
+	uint64_t time = anchor_us_ + (index / 2) * pair;
+	if (index & 1) {
+		time += pair * swing_ / 100;
+	}
+	return time;
+}
+
+void Clock::schedule(uint64_t time) {
+	alarm_target_us_ = time;
+	alarm_id_ = add_alarm_at(from_us_since_boot(time), &Clock::alarm_callback, this, true);
+}
+
+void Clock::cancel() {
+	if (alarm_id_ > 0) {
+		cancel_alarm(alarm_id_);
+	}
+	alarm_id_ = -1;
+}
+
+int64_t Clock::alarm_callback(alarm_id_t id, void* user_data) {
+	return static_cast<Clock*>(user_data)->handle_alarm();
+}
+
+int64_t Clock::handle_alarm() {
+	uint64_t current = alarm_target_us_;
+	uint64_t target;
+
+	if (output_high_) {
+		pulse_->set(false);
+		output_high_ = false;
+		target = tick_time(next_tick_);
+	} else {
+		// Predicted start of the next cycle, the next input edge corrects it
+		if (next_tick_ >= multiplier_) {
+			anchor_us_ += cycle_us_;
+			next_tick_ = 0;
+		}
+
+		pulse_->set(true);
+		output_high_ = true;
+		next_tick_ = next_tick_ + 1;
+
+		uint64_t gap = tick_time(next_tick_) - current;
+		uint64_t width = pulse_width_us_ > 0 ? pulse_width_us_ : gap / 2;
+		if (width >= gap) width = gap / 2;
+		target = current + (width > 0 ? width : 1);
+	}
+
+	// A negative return reschedules relative to the previous target instead of
+	// the callback's return, so alarm latency doesn't add up over the cycle
+	if (target <= current) target = current + 1;
+	alarm_target_us_ = target;
+	return -static_cast<int64_t>(target - current);
+}
+
+}  // namespace brain::io
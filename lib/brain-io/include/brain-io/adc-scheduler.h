@@ -0,0 +1,112 @@
+// Shared ADC scheduler for pots (ADC0 via 74HC4051) and audio/CV inputs (ADC1/ADC2)
+// Dependencies: ADC, GPIO, ADC FIFO interrupt. Hardware: pot mux on GPIO 26, CV on GPIO 27/28
+// Owns the single RP2040 ADC and interleaves all three inputs on a fixed timetable
+// Pin ownership: GPIO 26-28 (ADC0-2), pot mux select lines S0/S1
+// Author: Brain SDK
+#pragma once
+
+#include <cstdint>
+
+#include "brain-common/brain-gpio-setup.h"
+#include "pico/types.h"
+
+namespace brain::io {
+
+/**
+ * Central owner of the RP2040 ADC for apps that use pots and CV inputs together
+ *
+ * The ADC free-runs in round-robin over ADC0 (pot mux), ADC1 and ADC2 at a
+ * fixed round rate, and the FIFO interrupt collects one complete round at a
+ * time. CV channels are published every round. The pot mux stays on one pot
+ * for kSettleRounds + kSampleRounds rounds: the first rounds are discarded
+ * while the mux output settles (no busy-waiting), the rest are averaged,
+ * then the mux moves on.
+ *
+ * Latest values are published as aligned 16-bit stores, so consumers can read
+ * them at any time without locking. Pots and AudioCvIn take a scheduler in
+ * init() and then read from it instead of touching the ADC.
+ */
+class AdcScheduler {
+	public:
+	static constexpr uint8_t kMaxPotChannels = 4;
+	static constexpr uint32_t kDefaultRoundRate = 8000;	 // Rounds (3 conversions) per second
+	static constexpr uint8_t kSettleRounds = 2;	 // 250µs at the default rate
+	static constexpr uint8_t kSampleRounds = 6;
+
+	/**
+	 * Initialize ADC, mux select lines and start the timetable
+	 * @param num_pot_channels Number of mux channels to cycle through (1-4)
+	 * @param round_rate_hz Rounds per second, each round converts ADC0, ADC1 and ADC2
+	 * @param s0_gpio Mux select line S0
+	 * @param s1_gpio Mux select line S1
+	 * @return false if the parameters are out of range or another scheduler is running
+	 */
+	bool init(uint8_t num_pot_channels = 3, uint32_t round_rate_hz = kDefaultRoundRate,
+		uint s0_gpio = GPIO_BRAIN_POTMUX_S0, uint s1_gpio = GPIO_BRAIN_POTMUX_S1);
+
+	/**
+	 * Stop the timetable and release the ADC interrupt
+	 */
+	void stop();
+
+	/**
+	 * Select which physical mux channels are scanned, e.g. a pot channel map
+	 * init() scans channels 0 to num_pot_channels - 1. Pots::init() with a
+	 * scheduler calls this with its channel map.
+	 * @param mux_channels Physical mux channels (0-3), in scan order
+	 * @param count Number of channels (1-kMaxPotChannels)
+	 * @return false if count or a channel is out of range
+	 */
+	bool set_pot_channels(const uint8_t* mux_channels, uint8_t count);
+
+	bool is_running() const;
+
+	/**
+	 * Latest averaged pot reading
+	 * @param mux_channel Physical mux channel (0-3)
+	 * @return Raw 12-bit value, 0 for invalid channel
+	 */
+	uint16_t get_pot_raw(uint8_t mux_channel) const;
+
+	/**
+	 * Latest CV input reading
+	 * @param channel 0 for channel A (ADC1), 1 for channel B (ADC2)
+	 * @return Raw 12-bit value, 0 for invalid channel
+	 */
+	uint16_t get_cv_raw(uint8_t channel) const;
+
+	/**
+	 * Number of completed pot mux cycles, increments each time every pot has a new value
+	 */
+	uint32_t get_pot_cycle_count() const;
+
+	/**
+	 * Number of times the FIFO overflowed and the timetable was restarted
+	 */
+	uint32_t get_restart_count() const;
+
+	private:
+	static void adc_irq_handler();
+	void handle_round(uint16_t pot, uint16_t cv_a, uint16_t cv_b);
+	void restart();
+	void set_mux_channel(uint8_t ch);
+
+	bool running_ = false;
+	uint s0_gpio_ = GPIO_BRAIN_POTMUX_S0;
+	uint s1_gpio_ = GPIO_BRAIN_POTMUX_S1;
+	uint8_t num_pot_channels_ = 3;
+	uint8_t pot_channels_[kMaxPotChannels] = {0, 1, 2, 3};	// Physical mux channels in scan order
+
+	// Timetable position within the current pot
+	uint8_t scan_index_ = 0;
+	uint8_t round_ = 0;
+	uint32_t pot_sum_ = 0;
+
+	// Published values
+	volatile uint16_t pot_raw_[kMaxPotChannels] = {0, 0, 0, 0};
+	volatile uint16_t cv_raw_[2] = {0, 0};
+	volatile uint32_t pot_cycle_count_ = 0;
+	volatile uint32_t restart_count_ = 0;
+};
+
+}  // namespace brain::io
@@ -1,41 +1,183 @@
 // Audio/CV input via RP2040 ADC with configurable calibration
 // Dependencies: ADC, GPIO. Hardware: Two analog channels on GPIO 27/28
 // Reads ±5V signals that have been level-shifted to ~240mV-3V range
-// Pin ownership: GPIO 27 (ADC1), GPIO 28 (ADC2)
+// Pin ownership: GPIO 27 (ADC1), GPIO 28 (ADC2), two DMA channels while streaming
 // Author: Brain SDK
 #pragma once
 
 #include <hardware/adc.h>
 
+#include <cstddef>
 #include <cstdint>
 
 #include "brain-common/brain-common.h"
+#include "brain-utils/cic-decimator.h"
+#include "brain-utils/delegate.h"
+#include "brain-utils/schmitt-trigger.h"
 
 namespace brain::io {
 
+class AdcScheduler;
+
 enum AudioCvInChannel { kChannelA = 0, kChannelB = 1 };
 
+/**
+ * Per-channel linear calibration in fixed point:
+ * millivolts = ((raw * gain_q16) >> 16) + offset_mv
+ */
+struct AudioCvInCalibration {
+	int32_t gain_q16;  ///< Millivolts per ADC step, Q16 (keep below 8 mV/step)
+	int32_t offset_mv;  ///< Signal millivolts at ADC value 0
+};
+
+/** Threshold crossing detected on a streamed channel */
+struct AudioCvInEdge {
+	uint8_t channel;  ///< kChannelA or kChannelB
+	bool rising;  ///< true when crossing the high threshold, false for the low one
+	uint32_t time_us;  ///< time_us_32() of the sample that crossed
+};
+
 /**
  * Audio/CV input controller for two-channel analog input via RP2040 ADC
  *
  * Handles reading analog signals that have been level-shifted from ±5V range
  * to the RP2040 ADC input range. Provides both raw ADC values and converted
  * voltage values using configurable calibration constants.
+ *
+ * Two acquisition modes are available:
+ * - Polled: update() reads both channels with blocking ADC reads
+ * - Streaming: the ADC free-runs in round-robin over ADC1/ADC2 at a fixed
+ *   rate, DMA moves samples into double-buffered blocks and each completed
+ *   block is passed to a process callback
  */
 class AudioCvIn {
 	public:
+	/** Block callback: per-channel samples for A and B, n samples each */
+	using ProcessCallback =
+		brain::utils::Delegate<void(const uint16_t* a, const uint16_t* b, size_t n)>;
+
+	/** Samples per channel in each streamed block */
+	static constexpr size_t kStreamBlockSize = 64;
+
+	/** Maximum per-channel stream rate (500 ksps ADC shared by two channels) */
+	static constexpr uint32_t kMaxStreamSampleRate = 250000;
+
+	/** Entries in a full raw-to-millivolt lookup table (one per ADC value) */
+	static constexpr size_t kLookupTableSize = 4096;
+
+	/** Detected edges buffered until read with read_edge() */
+	static constexpr uint8_t kEdgeQueueSize = 16;
+
 	/**
 	 * Initialize ADC hardware and configure input channels
 	 * @return true if initialization successful, false on error
 	 */
 	bool init();
 
+	/**
+	 * Initialize for reading through a shared ADC scheduler
+	 * The scheduler owns the ADC; update() then copies its latest CV values and
+	 * streaming is unavailable.
+	 * @param scheduler Scheduler that owns the ADC (must outlive this object)
+	 * @return false if scheduler is null
+	 */
+	bool init(AdcScheduler* scheduler);
+
 	/**
 	 * Update ADC readings (call in main loop for continuous operation)
-	 * Refreshes internal readings for both channels
+	 * Refreshes internal readings for both channels. Does nothing while
+	 * streaming, readings are then refreshed with every block.
 	 */
 	void update();
 
+	/**
+	 * Start free-running capture of both channels via ADC round-robin and DMA
+	 * @param sample_rate_hz Per-channel sample rate (1 to kMaxStreamSampleRate)
+	 * @param process Called with every completed block, from the DMA interrupt.
+	 * Must return well within one block period (kStreamBlockSize / sample_rate_hz).
+	 * @return true if streaming started, false on invalid rate or no free DMA channel
+	 */
+	bool start_stream(uint32_t sample_rate_hz, ProcessCallback process);
+
+	/**
+	 * Stop streaming and release the DMA channels
+	 */
+	void stop_stream();
+
+	/**
+	 * Check if streaming capture is running
+	 * @return true while streaming
+	 */
+	bool is_streaming() const;
+
+	/**
+	 * Get the per-channel stream sample rate
+	 * @return Sample rate in Hz, or 0 if not streaming
+	 */
+	uint32_t get_stream_sample_rate() const;
+
+	/**
+	 * Run a CIC decimation filter over both streamed channels
+	 * Trades sample rate for resolution: the ADC's ~8.7 effective bits gain
+	 * about one bit per 4x of decimation, e.g. 2^10 at 250 kHz gives ~13-14
+	 * bits at 244 Hz. Only active while streaming.
+	 * @param decimation_log2 Decimation R = 2^decimation_log2 (1-10), 0 to disable
+	 * @return false if decimation_log2 is out of range
+	 */
+	bool set_oversampling(uint8_t decimation_log2);
+
+	/**
+	 * Get decimated reading for a channel
+	 * @param channel Channel number (kChannelA/kChannelB)
+	 * @return 16-bit value on the raw * 16 scale; raw << 4 when oversampling is off
+	 */
+	uint16_t get_raw_hires(int channel) const;
+
+	/**
+	 * Get decimated reading converted with the channel's calibration
+	 * @param channel Channel number (kChannelA/kChannelB)
+	 * @return Signal level in microvolts, 0 for invalid channel
+	 */
+	int32_t get_microvolts_hires(int channel) const;
+
+	/**
+	 * Get the rate at which decimated readings are updated
+	 * @return Output rate in Hz, or 0 if not streaming or oversampling is off
+	 */
+	uint32_t get_hires_sample_rate() const;
+
+	/**
+	 * Enable gate/trigger edge detection on a streamed channel
+	 * Each sample of every block runs through a Schmitt trigger, so edges are
+	 * timestamped to the sample instead of to the main loop.
+	 * @param channel Channel number (kChannelA/kChannelB)
+	 * @param low_mv Falling edge when the signal drops to this level
+	 * @param high_mv Rising edge when the signal reaches this level
+	 * @return false for invalid channel or if low_mv is not below high_mv
+	 */
+	bool set_edge_thresholds(int channel, int32_t low_mv, int32_t high_mv);
+
+	/**
+	 * Disable edge detection on a channel
+	 * @param channel Channel number (kChannelA/kChannelB)
+	 */
+	void disable_edge_detection(int channel);
+
+	/**
+	 * Take the oldest detected edge (call in main loop)
+	 * @param edge Filled with the edge if one is available
+	 * @return false if no edge is pending
+	 */
+	bool read_edge(AudioCvInEdge& edge);
+
+	/**
+	 * Convert a signal level to the raw ADC value with the channel's calibration
+	 * @param channel Channel number (kChannelA/kChannelB)
+	 * @param millivolts Signal level in millivolts
+	 * @return Raw ADC value, clamped to 0-4095
+	 */
+	uint16_t millivolts_to_raw(int channel, int32_t millivolts) const;
+
 	/**
 	 * Get raw ADC value for specified channel
 	 * @param channel Channel number (use BRAIN_AUDIO_CV_IN_CHANNEL_A/B constants)
@@ -43,6 +185,16 @@ class AudioCvIn {
 	 */
 	uint16_t get_raw(int channel) const;
 
+	/**
+	 * Read the freshest value of a channel, safe to call from interrupt handlers
+	 * Polled: a new conversion with interrupts disabled (about 2us).
+	 * Streaming: the last sample the DMA has written, at most one sample period old.
+	 * Scheduler: the scheduler's latest value, at most one round old.
+	 * @param channel Channel number (kChannelA/kChannelB)
+	 * @return Raw 12-bit ADC value (0-4095), 0 for invalid channel
+	 */
+	uint16_t sample_raw(int channel);
+
 	/**
 	 * Get raw ADC value for channel A
 	 * @return Raw 12-bit ADC value (0-4095)
@@ -74,19 +226,124 @@ class AudioCvIn {
 	 */
 	float get_voltage_channel_b() const;
 
+	/**
+	 * Get converted signal level in millivolts, integer only
+	 * @param channel Channel number (kChannelA/kChannelB)
+	 * @return Signal level in millivolts (about -5000 to +5000), 0 for invalid channel
+	 */
+	int32_t get_millivolts(int channel) const;
+
+	/**
+	 * Get converted signal level as Q15, integer only
+	 * @param channel Channel number (kChannelA/kChannelB)
+	 * @return -32768..32767 for -5V..+5V (clamped), 0 for invalid channel
+	 */
+	int16_t get_q15(int channel) const;
+
+	/**
+	 * Convert a raw ADC value with the channel's calibration
+	 * @param channel Channel number (kChannelA/kChannelB)
+	 * @param raw Raw 12-bit ADC value
+	 * @return Signal level in millivolts
+	 */
+	int32_t raw_to_millivolts(int channel, uint16_t raw) const;
+
+	/**
+	 * Convert a block of raw samples to millivolts (e.g. from the stream callback)
+	 * Uses the channel's lookup table if one is set, otherwise one multiply-add per sample.
+	 * @param channel Channel number (kChannelA/kChannelB)
+	 * @param raw Raw 12-bit samples
+	 * @param out_mv Output buffer for n values in millivolts
+	 * @param n Number of samples
+	 */
+	void convert_block_mv(int channel, const uint16_t* raw, int16_t* out_mv, size_t n) const;
+
+	/**
+	 * Set calibration for a channel (e.g. loaded from flash at runtime)
+	 * @param channel Channel number (kChannelA/kChannelB)
+	 * @param calibration Fixed-point gain and offset
+	 */
+	void set_calibration(int channel, const AudioCvInCalibration& calibration);
+
+	/**
+	 * Set calibration for a channel from two measured points
+	 * @param channel Channel number (kChannelA/kChannelB)
+	 * @param raw_at_minus_5v Raw ADC value measured with -5V at the input
+	 * @param raw_at_plus_5v Raw ADC value measured with +5V at the input
+	 * @return false if the points are invalid (equal or out of order)
+	 */
+	bool set_calibration_points(int channel, uint16_t raw_at_minus_5v, uint16_t raw_at_plus_5v);
+
+	/**
+	 * Get current calibration for a channel
+	 * @param channel Channel number (kChannelA/kChannelB)
+	 * @return Calibration, or channel A calibration for invalid channel
+	 */
+	AudioCvInCalibration get_calibration(int channel) const;
+
+	/**
+	 * Use a full lookup table for block conversion on a channel
+	 * The table is filled from the current calibration and refilled whenever
+	 * the calibration changes. Storage is owned by the caller.
+	 * @param channel Channel number (kChannelA/kChannelB)
+	 * @param table Storage for kLookupTableSize entries, or nullptr to disable
+	 */
+	void set_lookup_table(int channel, int16_t* table);
+
 	private:
 	/** Convert ADC reading to original signal voltage using calibration */
-	float adc_to_voltage(uint16_t adc_value) const;
+	float adc_to_voltage(int channel, uint16_t adc_value) const;
 
-	/** Calculate conversion parameters from calibration constants */
+	/** Calculate default calibration from the constants in brain-common.h */
 	void calculate_conversion_parameters();
 
+	/** Fill the channel's lookup table from its calibration */
+	void build_lookup_table(int channel);
+
+	static bool is_valid_channel(int channel) {
+		return channel == AudioCvInChannel::kChannelA || channel == AudioCvInChannel::kChannelB;
+	}
+
+	/** DMA completion interrupt, dispatches to the streaming instance */
+	static void dma_irq_handler();
+
+	/** Deinterleave a finished DMA buffer and hand it to the process callback */
+	void handle_block(uint8_t buffer_index, uint32_t block_end_us);
+
+	/** Run a channel's block through its edge detector and queue the edges */
+	void detect_edges(int channel, const uint16_t* block, uint32_t block_end_us);
+
 	// Current ADC readings for both channels
-	uint16_t channel_raw_[2] = {0, 0};
+	volatile uint16_t channel_raw_[2] = {0, 0};
+
+	// Shared ADC scheduler, if the ADC is owned by one
+	AdcScheduler* scheduler_ = nullptr;
+
+	// Streaming state: two chained DMA channels ping-pong between two buffers
+	// of interleaved A/B samples
+	bool streaming_ = false;
+	uint32_t stream_sample_rate_ = 0;
+	int dma_channel_[2] = {-1, -1};
+	uint16_t stream_buffer_[2][kStreamBlockSize * 2];
+	uint16_t block_a_[kStreamBlockSize];
+	uint16_t block_b_[kStreamBlockSize];
+	ProcessCallback process_;
+
+	// Optional decimation of the stream for high-resolution readings
+	uint8_t oversampling_log2_ = 0;
+	brain::utils::CicDecimator decimator_[2];
+
+	// Edge detection on the stream; the interrupt writes the queue head, read_edge() the tail
+	uint32_t sample_period_ns_ = 0;
+	volatile bool edge_detection_[2] = {false, false};
+	brain::utils::SchmittTrigger edge_detector_[2];
+	AudioCvInEdge edge_queue_[kEdgeQueueSize];
+	volatile uint8_t edge_head_ = 0;
+	volatile uint8_t edge_tail_ = 0;
 
-	// Conversion parameters calculated from calibration constants
-	float voltage_scale_ = 1.0f;
-	float voltage_offset_ = 0.0f;
+	// Per-channel calibration and optional caller-owned lookup tables
+	AudioCvInCalibration calibration_[2] = {{1 << 16, 0}, {1 << 16, 0}};
+	int16_t* lookup_table_[2] = {nullptr, nullptr};
 };
 
 }  // namespace brain::io
\ No newline at end of file
@@ -60,6 +60,32 @@ class AudioCvOut {
 		 */
 		bool set_voltage(AudioCvOutChannel channel, float voltage);
 
+		/**
+		 * Set raw DAC value on specified channel, skipping voltage conversion
+		 * Safe to call from interrupt handlers, each frame is sent with interrupts off
+		 * @param channel Target output channel (A or B)
+		 * @param dac_value 12-bit DAC value (0-4095), clamped if larger
+		 * @return true if value set successfully
+		 */
+		bool set_dac_value(AudioCvOutChannel channel, uint16_t dac_value);
+
+		/**
+		 * Set both channels back to back with interrupts disabled, so the pair
+		 * updates together and no other DAC write can land in between
+		 * @param dac_value_a 12-bit DAC value for channel A, clamped if larger
+		 * @param dac_value_b 12-bit DAC value for channel B, clamped if larger
+		 * @return true if values set successfully
+		 */
+		bool set_dac_values(uint16_t dac_value_a, uint16_t dac_value_b);
+
+		/**
+		 * Set output voltage on both channels as one paired write
+		 * @param voltage_a Channel A voltage in range 0.0V to 10.0V
+		 * @param voltage_b Channel B voltage in range 0.0V to 10.0V
+		 * @return false if either voltage is out of range, nothing is written then
+		 */
+		bool set_voltages(float voltage_a, float voltage_b);
+
 		/**
 		 * Configure DC/AC coupling for specified channel
 		 * @param channel Target output channel (A or B)
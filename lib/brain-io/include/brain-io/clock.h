@@ -0,0 +1,156 @@
+// Clock processor on top of Pulse: tempo tracking and synced multiplied/divided output.
+// Measures the input clock period and generates output clocks from a hardware alarm.
+// Requires: an initialized Pulse instance, one alarm from the default alarm pool.
+
+#ifndef BRAIN_IO_CLOCK_H_
+#define BRAIN_IO_CLOCK_H_
+
+#include <cstdint>
+
+#include "brain-io/pulse.h"
+#include "pico/time.h"
+
+namespace brain::io {
+
+/**
+ * @brief Clock multiplier/divider with period measurement, phase lock and swing
+ *
+ * Rising edges on the Pulse input are timestamped in the GPIO interrupt and
+ * delivered through Pulse::poll(). Each interval updates a running period
+ * estimate; intervals far off the estimate are rejected as outliers until
+ * they repeat, which is then treated as a tempo change.
+ *
+ * Output ticks are scheduled on absolute times by a hardware alarm, so they
+ * don't inherit main loop jitter. A cycle is `divider` input periods long and
+ * holds `multiplier` output ticks. Ticks are predicted from the period, and
+ * every input edge that starts a cycle re-anchors the schedule to its exact
+ * timestamp, keeping the output phase locked to the input.
+ */
+class Clock {
+	public:
+	static constexpr uint8_t kMaxRatio = 32;
+	static constexpr uint8_t kMinSwing = 50;  // Percent, straight
+	static constexpr uint8_t kMaxSwing = 75;
+	static constexpr uint8_t kHistorySize = 4;	// Intervals averaged for the period
+	static constexpr uint8_t kOutlierPercent = 25;	// Allowed deviation from the period
+	static constexpr uint8_t kMaxOutliers = 3;	// Matching outliers in a row mean a new tempo
+	static constexpr uint8_t kTimeoutPeriods = 3;  // Missing periods before the clock stops
+
+	~Clock();
+
+	/**
+	 * @brief Attach to a Pulse for input edges and output
+	 *
+	 * Registers a timestamped rise callback and enables edge capture
+	 * interrupts on the Pulse. Call pulse.poll() and update() regularly.
+	 *
+	 * @param pulse Initialized Pulse (must outlive this object)
+	 * @return false if pulse is null
+	 */
+	bool init(Pulse* pulse);
+
+	/**
+	 * @brief Output ticks per cycle (1-kMaxRatio)
+	 */
+	void set_multiplier(uint8_t multiplier);
+
+	/**
+	 * @brief Input periods per cycle (1-kMaxRatio)
+	 */
+	void set_divider(uint8_t divider);
+
+	/**
+	 * @brief Delay every second output tick
+	 *
+	 * @param percent Position of the odd tick within a pair of ticks,
+	 *                50 (straight) to 75 (hard shuffle)
+	 */
+	void set_swing(uint8_t percent);
+
+	/**
+	 * @brief Output pulse width
+	 *
+	 * @param us Width in microseconds, 0 for half the output period.
+	 *           Always capped to leave the output low before the next tick.
+	 */
+	void set_pulse_width_us(uint32_t us);
+
+	/**
+	 * @brief Input pulses per quarter note, used for get_bpm()
+	 */
+	void set_input_ppqn(uint8_t ppqn);
+
+	/**
+	 * @brief Stop the output when the input clock stops
+	 *
+	 * Call regularly in the main loop.
+	 */
+	void update();
+
+	/**
+	 * @brief Stop output until the next input edges lock again
+	 */
+	void stop();
+
+	/**
+	 * @brief Measured input period
+	 *
+	 * @return Period in microseconds, 0 if not locked
+	 */
+	uint32_t get_period_us() const;
+
+	/**
+	 * @brief Tempo of the input clock
+	 *
+	 * @return Beats per minute based on the input PPQN, 0 if not locked
+	 */
+	float get_bpm() const;
+
+	/**
+	 * @brief Whether the period is known and the output is running
+	 */
+	bool is_locked() const;
+
+	private:
+	static int64_t alarm_callback(alarm_id_t id, void* user_data);
+	int64_t handle_alarm();
+	void handle_input(uint32_t time_us);
+	bool update_period(uint32_t time_us);
+	void push_interval(uint32_t interval);
+	uint64_t tick_time(uint8_t index) const;
+	uint32_t tick_step_us() const;
+	void schedule(uint64_t time);
+	void cancel();
+
+	Pulse* pulse_ = nullptr;
+	uint8_t multiplier_ = 1;
+	uint8_t divider_ = 1;
+	uint8_t swing_ = kMinSwing;
+	uint32_t pulse_width_us_ = 0;
+	uint8_t input_ppqn_ = 1;
+
+	// Period measurement
+	uint32_t history_[kHistorySize] = {0, 0, 0, 0};
+	uint8_t history_count_ = 0;
+	uint8_t history_pos_ = 0;
+	uint8_t outliers_ = 0;
+	uint32_t last_outlier_us_ = 0;	///< Interval of the previous outlier
+	uint32_t period_us_ = 0;
+	uint32_t last_edge_us_ = 0;  ///< Last edge accepted as a beat
+	uint32_t last_raw_edge_us_ = 0;	 ///< Last edge, including rejected ones
+	bool has_edge_ = false;
+	uint8_t input_count_ = 0;
+
+	// Output schedule, shared with the alarm interrupt
+	uint64_t anchor_us_ = 0;  ///< Time of tick 0 in the current cycle
+	uint32_t cycle_us_ = 0;
+	volatile uint8_t next_tick_ = 0;  ///< Next tick, multiplier_ means tick 0 of the next cycle
+	volatile bool output_high_ = false;
+	volatile uint64_t alarm_target_us_ = 0;
+	alarm_id_t alarm_id_ = -1;
+	bool locked_ = false;
+};
+
+}  // namespace brain::io
+
+#endif	// BRAIN_IO_CLOCK_H_
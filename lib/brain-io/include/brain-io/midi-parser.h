@@ -2,6 +2,7 @@
 
 #include <cstdint>
 
+#include "brain-utils/delegate.h"
 #include "brain-utils/ringbuffer.h"
 
 // Forward declarations for UART types
@@ -13,16 +14,30 @@ namespace brain::io {
  * @brief MIDI parser with integrated UART input for channel voice messages.
  * Handles UART MIDI input and parsing with channel filtering and Omni mode support.
  * ISR-safe parse() method for real-time parsing or use initUart() for integrated UART handling.
+ *
+ * Callbacks accept plain functions, lambdas capturing a few pointers, or a function taking a
+ * `void* user` context as first argument, so several parsers can each call into their own
+ * handler object directly.
  */
 class MidiParser {
 
 public:
 	// Callback function types
-	using NoteOnCallback = void (*)(uint8_t note, uint8_t velocity, uint8_t channel);
-	using NoteOffCallback = void (*)(uint8_t note, uint8_t velocity, uint8_t channel);
-	using ControlChangeCallback = void (*)(uint8_t cc, uint8_t value, uint8_t channel);
-	using PitchBendCallback = void (*)(int16_t value, uint8_t channel);
-	using RealtimeCallback = void (*)(uint8_t status);
+	using NoteOnCallback = brain::utils::Delegate<void(uint8_t note, uint8_t velocity,
+		uint8_t channel)>;
+	using NoteOffCallback = brain::utils::Delegate<void(uint8_t note, uint8_t velocity,
+		uint8_t channel)>;
+	using ControlChangeCallback = brain::utils::Delegate<void(uint8_t cc, uint8_t value,
+		uint8_t channel)>;
+	using PitchBendCallback = brain::utils::Delegate<void(int16_t value, uint8_t channel)>;
+	using RealtimeCallback = brain::utils::Delegate<void(uint8_t status)>;
+
+	// Same callbacks with a user context pointer as first argument
+	using NoteOnUserCallback = NoteOnCallback::Function;
+	using NoteOffUserCallback = NoteOffCallback::Function;
+	using ControlChangeUserCallback = ControlChangeCallback::Function;
+	using PitchBendUserCallback = PitchBendCallback::Function;
+	using RealtimeUserCallback = RealtimeCallback::Function;
 
 	/**
 	 * @brief Constructor with optional configuration
@@ -120,6 +135,17 @@ public:
 	 */
 	void set_realtime_callback(RealtimeCallback callback);
 
+	/**
+	 * @brief Set callbacks that receive a user context pointer
+	 * @param callback Function taking `void* user` followed by the message arguments
+	 * @param user Passed unchanged to every call, e.g. the handler object
+	 */
+	void set_note_on_callback(NoteOnUserCallback callback, void* user);
+	void set_note_off_callback(NoteOffUserCallback callback, void* user);
+	void set_control_change_callback(ControlChangeUserCallback callback, void* user);
+	void set_pitch_bend_callback(PitchBendUserCallback callback, void* user);
+	void set_realtime_callback(RealtimeUserCallback callback, void* user);
+
 private:
 	// Parser state machine states
 	enum class State : uint8_t { Idle, AwaitData1, AwaitData2 };
@@ -197,11 +223,11 @@ private:
 	bool uart_initialized_ = false;
 
 	// Callbacks
-	NoteOnCallback note_on_callback_ = nullptr;
-	NoteOffCallback note_off_callback_ = nullptr;
-	ControlChangeCallback control_change_callback_ = nullptr;
-	PitchBendCallback pitch_bend_callback_ = nullptr;
-	RealtimeCallback realtime_callback_ = nullptr;
+	NoteOnCallback note_on_callback_;
+	NoteOffCallback note_off_callback_;
+	ControlChangeCallback control_change_callback_;
+	PitchBendCallback pitch_bend_callback_;
+	RealtimeCallback realtime_callback_;
 };
 
 }  // namespace brain::io
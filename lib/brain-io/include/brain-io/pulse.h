@@ -6,13 +6,22 @@
 #define BRAIN_IO_PULSE_H_
 
 #include <cstdint>
-#include <functional>
 
 #include "brain-common/brain-gpio-setup.h"
+#include "brain-utils/delegate.h"
+#include "pico/time.h"
 #include "pico/types.h"
 
 namespace brain::io {
 
+/**
+ * @brief Input edge captured by the GPIO interrupt
+ */
+struct PulseEdge {
+	uint32_t time_us;  ///< time_us_32() when the interrupt ran
+	bool rising;  ///< Logical edge direction (hardware inversion handled)
+};
+
 /**
  * @brief Pulse input/output handler with hardware inversion support
  *
@@ -22,6 +31,12 @@ namespace brain::io {
  */
 class Pulse {
 	public:
+	/** Captured edges buffered until poll() */
+	static constexpr uint8_t kEdgeQueueSize = 32;
+
+	/** Scheduled triggers and bursts waiting for their start time */
+	static constexpr uint8_t kTriggerQueueSize = 8;
+
 	/**
 	 * @brief Construct a new Pulse object
 	 *
@@ -61,6 +76,61 @@ class Pulse {
 	 */
 	void set(bool on);
 
+	/**
+	 * @brief Fire a trigger pulse now
+	 *
+	 * The output goes high right away and a hardware alarm ends the pulse,
+	 * so the width doesn't depend on the main loop.
+	 *
+	 * @param width_us Pulse width in microseconds
+	 * @return false if width is 0 or the trigger queue is full
+	 */
+	bool trigger(uint32_t width_us);
+
+	/**
+	 * @brief Schedule a trigger pulse
+	 *
+	 * @param time_us Start time on the time_us_32() clock, e.g. an input
+	 *                edge timestamp plus a delay. Times in the past fire now.
+	 * @param width_us Pulse width in microseconds
+	 * @return false if width is 0 or the trigger queue is full
+	 */
+	bool trigger_at(uint32_t time_us, uint32_t width_us);
+
+	/**
+	 * @brief Fire a burst (ratchet) of trigger pulses starting now
+	 *
+	 * @param count Number of pulses
+	 * @param width_us Width of each pulse in microseconds
+	 * @param interval_us Time between pulse starts, must exceed width_us
+	 * @return false if parameters are invalid or the trigger queue is full
+	 */
+	bool burst(uint16_t count, uint32_t width_us, uint32_t interval_us);
+
+	/**
+	 * @brief Schedule a burst of trigger pulses
+	 *
+	 * A burst takes one queue entry; the alarm re-queues it after every
+	 * pulse, so there is no main loop involvement between pulses.
+	 *
+	 * @param time_us Start time of the first pulse on the time_us_32() clock
+	 * @param count Number of pulses
+	 * @param width_us Width of each pulse in microseconds
+	 * @param interval_us Time between pulse starts, must exceed width_us
+	 * @return false if parameters are invalid or the trigger queue is full
+	 */
+	bool burst_at(uint32_t time_us, uint16_t count, uint32_t width_us, uint32_t interval_us);
+
+	/**
+	 * @brief Drop all scheduled triggers and end the current one
+	 */
+	void cancel_triggers();
+
+	/**
+	 * @brief Whether a trigger pulse is high or scheduled
+	 */
+	bool is_triggering() const;
+
 	/**
 	 * @brief Get last commanded logical output state
 	 *
@@ -73,17 +143,48 @@ class Pulse {
 	 *
 	 * @param cb Callback function to invoke
 	 */
-	void on_rise(std::function<void()> cb);
+	void on_rise(brain::utils::Delegate<void()> cb);
 
 	/**
 	 * @brief Set callback for logical falling edge (high→low)
 	 *
 	 * @param cb Callback function to invoke
 	 */
-	void on_fall(std::function<void()> cb);
+	void on_fall(brain::utils::Delegate<void()> cb);
+
+	/**
+	 * @brief Set callback for logical rising edge with its timestamp
+	 *
+	 * @param cb Callback function: void(uint32_t time_us)
+	 */
+	void on_rise_timed(brain::utils::Delegate<void(uint32_t)> cb);
+
+	/**
+	 * @brief Set callback for logical falling edge with its timestamp
+	 *
+	 * @param cb Callback function: void(uint32_t time_us)
+	 */
+	void on_fall_timed(brain::utils::Delegate<void(uint32_t)> cb);
+
+	/**
+	 * @brief Set callback run inside the GPIO interrupt for every input edge
+	 *
+	 * For work that can't wait for poll(), like sample and hold. Repeated
+	 * directions are skipped; as the interrupt can't wait for a stable level,
+	 * the glitch filter only drops edges closer than the filter time to the
+	 * last accepted one. Edges are still queued for poll() too. Keep it short.
+	 * Needs enable_interrupts().
+	 *
+	 * @param cb Callback function: void(bool rising, uint32_t time_us)
+	 */
+	void on_edge_irq(brain::utils::Delegate<void(bool, uint32_t)> cb);
 
 	/**
 	 * @brief Poll for edge detection (call in main loop)
+	 *
+	 * With interrupts enabled this drains the edge queue instead of
+	 * sampling the input, firing callbacks for every captured edge in
+	 * order with its interrupt timestamp.
 	 */
 	void poll();
 
@@ -104,6 +205,13 @@ class Pulse {
 	 */
 	void disable_interrupts();
 
+	/**
+	 * @brief Number of edges dropped because the queue was full
+	 *
+	 * Call poll() more often if this increases.
+	 */
+	uint32_t get_dropped_edges() const;
+
 	private:
 	uint in_gpio_;
 	uint out_gpio_;
@@ -112,15 +220,52 @@ class Pulse {
 	uint32_t glitch_filter_us_;
 	bool interrupts_enabled_;
 
-	std::function<void()> on_rise_callback_;
-	std::function<void()> on_fall_callback_;
+	brain::utils::Delegate<void()> on_rise_callback_;
+	brain::utils::Delegate<void()> on_fall_callback_;
+	brain::utils::Delegate<void(uint32_t)> on_rise_timed_callback_;
+	brain::utils::Delegate<void(uint32_t)> on_fall_timed_callback_;
+	brain::utils::Delegate<void(bool, uint32_t)> on_edge_irq_callback_;
 
 	// For glitch filtering
 	uint32_t last_change_time_us_;
 	bool filtered_state_;
 
+	// Edge capture; the interrupt writes the queue head, poll() the tail
+	PulseEdge edge_queue_[kEdgeQueueSize];
+	volatile uint8_t edge_head_ = 0;
+	volatile uint8_t edge_tail_ = 0;
+	volatile uint32_t dropped_edges_ = 0;
+	uint32_t last_edge_time_us_ = 0;
+
+	// Edge state as seen by the interrupt callback, kept apart from poll()'s
+	bool irq_last_state_ = false;
+	uint32_t irq_last_edge_us_ = 0;
+
+	// Scheduled triggers sorted by start time, shared with the alarm interrupt
+	struct ScheduledTrigger {
+		uint32_t time_us;
+		uint32_t width_us;
+		uint32_t interval_us;
+		uint16_t count;
+	};
+	ScheduledTrigger triggers_[kTriggerQueueSize];
+	volatile uint8_t trigger_count_ = 0;
+	volatile bool trigger_high_ = false;
+	uint32_t high_until_us_ = 0;
+	alarm_id_t trigger_alarm_ = -1;
+	uint64_t trigger_target_us_ = 0;
+
 	static void gpio_irq_handler(uint gpio, uint32_t events);
-	void handle_edge(bool raw_state);
+	static int64_t trigger_alarm_callback(alarm_id_t id, void* user_data);
+	void insert_trigger(const ScheduledTrigger& trigger);
+	bool next_trigger_event(uint32_t* time_us) const;
+	void process_triggers(uint32_t now);
+	void schedule_triggers();
+	void handle_edge(uint32_t events);
+	void push_edge(bool rising, uint32_t time_us);
+	void dispatch_irq_edge(bool rising, uint32_t time_us);
+	void poll_queue();
+	void fire(bool rising, uint32_t time_us);
 };
 
 }  // namespace brain::io
@@ -144,6 +144,26 @@ void MidiParser::set_realtime_callback(RealtimeCallback callback) {
 	realtime_callback_ = callback;
 }
 
+void MidiParser::set_note_on_callback(NoteOnUserCallback callback, void* user) {
+	note_on_callback_ = NoteOnCallback(callback, user);
+}
+
+void MidiParser::set_note_off_callback(NoteOffUserCallback callback, void* user) {
+	note_off_callback_ = NoteOffCallback(callback, user);
+}
+
+void MidiParser::set_control_change_callback(ControlChangeUserCallback callback, void* user) {
+	control_change_callback_ = ControlChangeCallback(callback, user);
+}
+
+void MidiParser::set_pitch_bend_callback(PitchBendUserCallback callback, void* user) {
+	pitch_bend_callback_ = PitchBendCallback(callback, user);
+}
+
+void MidiParser::set_realtime_callback(RealtimeUserCallback callback, void* user) {
+	realtime_callback_ = RealtimeCallback(callback, user);
+}
+
 bool MidiParser::init_uart(uint32_t baud_rate) {
 	// Use default Brain module configuration: UART1 with GPIO_BRAIN_MIDI_RX
 	return init_uart(uart1, GPIO_BRAIN_MIDI_RX, baud_rate);
@@ -7,6 +7,7 @@
 #include <algorithm>
 
 #include "hardware/gpio.h"
+#include "hardware/sync.h"
 #include "hardware/timer.h"
 #include "pico/time.h"
 #include "pico/types.h"
@@ -53,6 +54,7 @@ void Pulse::end() {
 	if (interrupts_enabled_) {
 		disable_interrupts();
 	}
+	cancel_triggers();
 
 	// Clear IRQ instance
 	if (in_gpio_ < NUM_BANK0_GPIOS) {
@@ -88,15 +90,219 @@ bool Pulse::get() const {
 	return current_output_state_;
 }
 
-void Pulse::on_rise(std::function<void()> cb) {
+bool Pulse::trigger(uint32_t width_us) {
+	return burst_at(time_us_32(), 1, width_us, 0);
+}
+
+bool Pulse::trigger_at(uint32_t time_us, uint32_t width_us) {
+	return burst_at(time_us, 1, width_us, 0);
+}
+
+bool Pulse::burst(uint16_t count, uint32_t width_us, uint32_t interval_us) {
+	return burst_at(time_us_32(), count, width_us, interval_us);
+}
+
+bool Pulse::burst_at(uint32_t time_us, uint16_t count, uint32_t width_us, uint32_t interval_us) {
+	if (count == 0 || width_us == 0 || (count > 1 && interval_us <= width_us)) {
+		return false;
+	}
+
+	// The alarm interrupt works on the same queue
+	uint32_t status = save_and_disable_interrupts();
+	if (trigger_count_ >= kTriggerQueueSize) {
+		restore_interrupts(status);
+		return false;
+	}
+
+	insert_trigger({time_us, width_us, interval_us, count});
+	schedule_triggers();
+	restore_interrupts(status);
+
+	return true;
+}
+
+void Pulse::cancel_triggers() {
+	uint32_t status = save_and_disable_interrupts();
+	if (trigger_alarm_ > 0) {
+		cancel_alarm(trigger_alarm_);
+		trigger_alarm_ = -1;
+	}
+	trigger_count_ = 0;
+	if (trigger_high_) {
+		trigger_high_ = false;
+		set(false);
+	}
+	restore_interrupts(status);
+}
+
+bool Pulse::is_triggering() const {
+	return trigger_high_ || trigger_count_ > 0;
+}
+
+void Pulse::insert_trigger(const ScheduledTrigger& trigger) {
+	// Few entries, so an insertion sort keeps the earliest at the front
+	uint8_t i = trigger_count_;
+	while (i > 0 && static_cast<int32_t>(triggers_[i - 1].time_us - trigger.time_us) > 0) {
+		triggers_[i] = triggers_[i - 1];
+		i--;
+	}
+	triggers_[i] = trigger;
+	trigger_count_ = trigger_count_ + 1;
+}
+
+bool Pulse::next_trigger_event(uint32_t* time_us) const {
+	bool has_event = false;
+
+	if (trigger_high_) {
+		*time_us = high_until_us_;
+		has_event = true;
+	}
+	if (trigger_count_ > 0 &&
+		(!has_event || static_cast<int32_t>(triggers_[0].time_us - *time_us) < 0)) {
+		*time_us = triggers_[0].time_us;
+		has_event = true;
+	}
+
+	return has_event;
+}
+
+void Pulse::process_triggers(uint32_t now) {
+	if (trigger_high_ && static_cast<int32_t>(now - high_until_us_) >= 0) {
+		trigger_high_ = false;
+		set(false);
+	}
+
+	while (trigger_count_ > 0 && static_cast<int32_t>(now - triggers_[0].time_us) >= 0) {
+		ScheduledTrigger trigger = triggers_[0];
+		trigger_count_ = trigger_count_ - 1;
+		for (uint8_t i = 0; i < trigger_count_; i++) {
+			triggers_[i] = triggers_[i + 1];
+		}
+
+		// Overlapping triggers merge into one longer pulse
+		uint32_t end = trigger.time_us + trigger.width_us;
+		if (!trigger_high_ || static_cast<int32_t>(end - high_until_us_) > 0) {
+			high_until_us_ = end;
+		}
+		trigger_high_ = true;
+		set(true);
+
+		if (trigger.count > 1) {
+			trigger.count--;
+			trigger.time_us += trigger.interval_us;
+			insert_trigger(trigger);
+		}
+	}
+}
+
+void Pulse::schedule_triggers() {
+	if (trigger_alarm_ > 0) {
+		cancel_alarm(trigger_alarm_);
+		trigger_alarm_ = -1;
+	}
+
+	uint32_t next;
+	if (!next_trigger_event(&next)) {
+		return;
+	}
+
+	int32_t delay = static_cast<int32_t>(next - time_us_32());
+	trigger_target_us_ = time_us_64() + (delay > 0 ? delay : 0);
+	trigger_alarm_ = add_alarm_at(
+		from_us_since_boot(trigger_target_us_), &Pulse::trigger_alarm_callback, this, true);
+}
+
+int64_t Pulse::trigger_alarm_callback(alarm_id_t id, void* user_data) {
+	Pulse* self = static_cast<Pulse*>(user_data);
+	self->process_triggers(time_us_32());
+
+	uint32_t next;
+	if (!self->next_trigger_event(&next)) {
+		self->trigger_alarm_ = -1;
+		return 0;
+	}
+
+	// A negative return reschedules relative to the previous target time, a
+	// positive one would count from now and add the interrupt latency
+	uint64_t target = time_us_64() + static_cast<int32_t>(next - time_us_32());
+	int64_t delta = static_cast<int64_t>(target - self->trigger_target_us_);
+	if (delta <= 0) delta = 1;
+	self->trigger_target_us_ += delta;
+	return -delta;
+}
+
+void Pulse::on_rise(brain::utils::Delegate<void()> cb) {
 	on_rise_callback_ = cb;
 }
 
-void Pulse::on_fall(std::function<void()> cb) {
+void Pulse::on_fall(brain::utils::Delegate<void()> cb) {
 	on_fall_callback_ = cb;
 }
 
+void Pulse::on_rise_timed(brain::utils::Delegate<void(uint32_t)> cb) {
+	on_rise_timed_callback_ = cb;
+}
+
+void Pulse::on_fall_timed(brain::utils::Delegate<void(uint32_t)> cb) {
+	on_fall_timed_callback_ = cb;
+}
+
+void Pulse::on_edge_irq(brain::utils::Delegate<void(bool, uint32_t)> cb) {
+	// The interrupt may call it while it's being replaced
+	uint32_t status = save_and_disable_interrupts();
+	on_edge_irq_callback_ = cb;
+	restore_interrupts(status);
+}
+
+void Pulse::fire(bool rising, uint32_t time_us) {
+	if (rising) {
+		if (on_rise_callback_) on_rise_callback_();
+		if (on_rise_timed_callback_) on_rise_timed_callback_(time_us);
+	} else {
+		if (on_fall_callback_) on_fall_callback_();
+		if (on_fall_timed_callback_) on_fall_timed_callback_(time_us);
+	}
+}
+
+void Pulse::poll_queue() {
+	uint32_t now = time_us_32();
+
+	while (edge_tail_ != edge_head_) {
+		PulseEdge edge = edge_queue_[edge_tail_];
+		uint8_t next = (edge_tail_ + 1) & (kEdgeQueueSize - 1);
+
+		// The level has to hold for the filter time: an edge undone within it is
+		// dropped together with its return, one too recent to tell waits
+		if (glitch_filter_us_ > 0) {
+			if (next != edge_head_) {
+				if (edge_queue_[next].time_us - edge.time_us < glitch_filter_us_) {
+					edge_tail_ = (next + 1) & (kEdgeQueueSize - 1);
+					continue;
+				}
+			} else if (static_cast<int32_t>(now - edge.time_us) <
+				static_cast<int32_t>(glitch_filter_us_)) {
+				break;
+			}
+		}
+		edge_tail_ = next;
+
+		// Repeated directions mean an edge was dropped
+		if (edge.rising == last_logical_state_) {
+			continue;
+		}
+
+		last_logical_state_ = edge.rising;
+		last_edge_time_us_ = edge.time_us;
+		fire(edge.rising, edge.time_us);
+	}
+}
+
 void Pulse::poll() {
+	if (interrupts_enabled_) {
+		poll_queue();
+		return;
+	}
+
 	bool current_logical = read();
 
 	// Apply glitch filtering if enabled
@@ -119,13 +325,8 @@ void Pulse::poll() {
 
 	// Detect edges and fire callbacks
 	if (current_logical != last_logical_state_) {
-		if (current_logical && on_rise_callback_) {
-			on_rise_callback_();
-		} else if (!current_logical && on_fall_callback_) {
-			on_fall_callback_();
-		}
-
 		last_logical_state_ = current_logical;
+		fire(current_logical, time_us_32());
 	}
 }
 
@@ -135,6 +336,13 @@ void Pulse::set_input_glitch_filter_us(uint32_t us) {
 
 void Pulse::enable_interrupts() {
 	if (!interrupts_enabled_) {
+		edge_head_ = 0;
+		edge_tail_ = 0;
+		last_logical_state_ = read();
+		last_edge_time_us_ = time_us_32() - glitch_filter_us_;
+		irq_last_state_ = last_logical_state_;
+		irq_last_edge_us_ = last_edge_time_us_;
+
 		gpio_set_irq_enabled_with_callback(
 			in_gpio_, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, true, &gpio_irq_handler);
 		interrupts_enabled_ = true;
@@ -148,20 +356,76 @@ void Pulse::disable_interrupts() {
 	}
 }
 
+uint32_t Pulse::get_dropped_edges() const {
+	return dropped_edges_;
+}
+
 void Pulse::gpio_irq_handler(uint gpio, uint32_t events) {
 	if (gpio < NUM_BANK0_GPIOS && irq_instances[gpio] != nullptr) {
-		// In ISR context - just record that an edge occurred
-		// The actual edge processing happens in Poll() in main loop
-		bool raw_state = gpio_get(gpio);
-		irq_instances[gpio]->handle_edge(raw_state);
+		// In ISR context - just capture the edge with its timestamp
+		// The actual edge processing happens in poll() in main loop
+		irq_instances[gpio]->handle_edge(events);
 	}
 }
 
-void Pulse::handle_edge(bool raw_state) {
+void Pulse::handle_edge(uint32_t events) {
 	// This is called from ISR - keep it minimal
-	// The actual callback invocation happens in Poll()
-	// Just update timing for glitch filter
-	last_change_time_us_ = time_us_32();
+	uint32_t now = time_us_32();
+	last_change_time_us_ = now;
+
+	// Input is inverted: a raw falling edge is a logical rising edge
+	bool raw_rise = events & GPIO_IRQ_EDGE_RISE;
+	bool raw_fall = events & GPIO_IRQ_EDGE_FALL;
+
+	if (raw_rise && raw_fall) {
+		// Pulse shorter than the interrupt latency, the current level tells the order
+		bool logical_now = !gpio_get(in_gpio_);
+		push_edge(!logical_now, now);
+		push_edge(logical_now, now);
+
+		// Shorter than any glitch filter, so the interrupt callback only sees it unfiltered
+		if (glitch_filter_us_ == 0) {
+			dispatch_irq_edge(!logical_now, now);
+			dispatch_irq_edge(logical_now, now);
+		}
+	} else if (raw_rise || raw_fall) {
+		push_edge(raw_fall, now);
+		dispatch_irq_edge(raw_fall, now);
+	}
+}
+
+void Pulse::push_edge(bool rising, uint32_t time_us) {
+	uint8_t next = (edge_head_ + 1) & (kEdgeQueueSize - 1);
+	if (next == edge_tail_) {
+		dropped_edges_ = dropped_edges_ + 1;
+		return;
+	}
+
+	edge_queue_[edge_head_].time_us = time_us;
+	edge_queue_[edge_head_].rising = rising;
+	edge_head_ = next;
+}
+
+void Pulse::dispatch_irq_edge(bool rising, uint32_t time_us) {
+	if (!on_edge_irq_callback_) {
+		return;
+	}
+
+	if (rising == irq_last_state_) {
+		return;
+	}
+
+	// The interrupt can't wait for the level to settle, so edges too close to
+	// the last accepted one are dropped. The state then follows the pin, so
+	// the return of a glitch doesn't make the next real edge look repeated.
+	if (glitch_filter_us_ > 0 && (time_us - irq_last_edge_us_) < glitch_filter_us_) {
+		irq_last_state_ = read();
+		return;
+	}
+
+	irq_last_state_ = rising;
+	irq_last_edge_us_ = time_us;
+	on_edge_irq_callback_(rising, time_us);
 }
 
 }  // namespace brain::io
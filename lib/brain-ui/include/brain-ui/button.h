@@ -6,8 +6,8 @@
 #define BRAIN_UI_BUTTON_H_
 
 #include <cstdint>
-#include <functional>
 
+#include "brain-utils/delegate.h"
 #include "pico/stdlib.h"
 
 namespace brain::ui {
@@ -50,28 +50,28 @@ class Button {
 	 *
 	 * @param callback Function to invoke when button is pressed (after debounce)
 	 */
-	void set_on_press(std::function<void()> callback);
+	void set_on_press(brain::utils::Delegate<void()> callback);
 
 	/**
 	 * @brief Set callback for button release event
 	 *
 	 * @param callback Function to invoke when button is released (after debounce)
 	 */
-	void set_on_release(std::function<void()> callback);
+	void set_on_release(brain::utils::Delegate<void()> callback);
 
 	/**
 	 * @brief Set callback for single tap event
 	 *
 	 * @param callback Function to invoke for quick press-release cycles
 	 */
-	void set_on_single_tap(std::function<void()> callback);
+	void set_on_single_tap(brain::utils::Delegate<void()> callback);
 
 	/**
 	 * @brief Set callback for long press event
 	 *
 	 * @param callback Function to invoke when button is held beyond threshold
 	 */
-	void set_on_long_press(std::function<void()> callback);
+	void set_on_long_press(brain::utils::Delegate<void()> callback);
 
 	private:
 	uint gpio_pin_;	 ///< GPIO pin number for button input
@@ -82,10 +82,10 @@ class Button {
 	uint32_t debounce_ms_;	///< Debounce time in milliseconds
 	uint32_t long_press_ms_;  ///< Long press threshold in milliseconds
 
-	std::function<void()> on_press_;  ///< Callback for press events
-	std::function<void()> on_release_;	///< Callback for release events
-	std::function<void()> on_single_tap_;  ///< Callback for single tap events
-	std::function<void()> on_long_press_;  ///< Callback for long press events
+	brain::utils::Delegate<void()> on_press_;  ///< Callback for press events
+	brain::utils::Delegate<void()> on_release_;	///< Callback for release events
+	brain::utils::Delegate<void()> on_single_tap_;  ///< Callback for single tap events
+	brain::utils::Delegate<void()> on_long_press_;  ///< Callback for long press events
 
 	bool long_press_triggered_;	 ///< Flag to prevent multiple long press events
 	bool last_state_;  ///< Last debounced state for edge detection
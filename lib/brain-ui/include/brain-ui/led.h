@@ -3,7 +3,8 @@
 #include <pico/stdlib.h>
 
 #include <cstdint>
-#include <functional>
+
+#include "brain-utils/delegate.h"
 
 namespace brain::ui {
 
@@ -91,14 +92,14 @@ class Led {
 	 *
 	 * @param callback Function to invoke when LED state changes (on/off)
 	 */
-	void set_on_state_change(std::function<void(bool)> callback);
+	void set_on_state_change(brain::utils::Delegate<void(bool)> callback);
 
 	/**
 	 * @brief Set callback for end of blink sequence
 	 *
 	 * @param callback Function to invoke when blink pattern completes
 	 */
-	void set_on_blink_end(std::function<void()> callback);
+	void set_on_blink_end(brain::utils::Delegate<void()> callback);
 
 	/**
 	 * @brief Check if LED is currently on
@@ -124,8 +125,8 @@ class Led {
 	uint blink_interval_ms_;  ///< Time between blink state changes
 	uint blink_count_;	///< Current blink count for tracking
 	absolute_time_t last_blink_time_;  ///< Timestamp of last blink state change
-	std::function<void(bool)> on_state_change_;	 ///< Callback for state change events
-	std::function<void()> on_blink_end_;  ///< Callback for blink sequence completion
+	brain::utils::Delegate<void(bool)> on_state_change_;	 ///< Callback for state change events
+	brain::utils::Delegate<void()> on_blink_end_;  ///< Callback for blink sequence completion
 	// For blinkDuration
 	bool duration_blink_ = false;  ///< True for duration-based blinking
 	uint duration_ms_ = 0;	///< Total duration for duration-based blink
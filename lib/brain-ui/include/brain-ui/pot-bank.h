@@ -0,0 +1,139 @@
+// Paged parameter banks on top of Pots, with soft-takeover.
+// Lets a few physical pots edit many parameters, one page at a time.
+// Requires: an initialized Pots instance.
+
+#ifndef BRAIN_UI_POT_BANK_H_
+#define BRAIN_UI_POT_BANK_H_
+
+#include <cstdint>
+
+#include "brain-ui/pots.h"
+#include "brain-utils/delegate.h"
+
+namespace brain::ui {
+
+/**
+ * @brief How a pot takes over a stored value after a page switch
+ */
+enum PotBankMode {
+	kPotModeJump = 0,  ///< Value follows the pot as soon as it moves
+	kPotModePickup = 1,	 ///< Value follows once the pot passes it (or comes within the window)
+	kPotModeScale = 2,	///< Value moves proportionally towards the end the pot is moving to
+	kPotModeRelative = 3,  ///< Value moves by the same amount as the pot
+};
+
+/**
+ * @brief Paged parameter banks for multiplexed pots
+ *
+ * Stores num_pages x num_pots values in the Pots output resolution. Only
+ * the current page follows the physical pots; switching pages just changes
+ * an index and marks all pots as not yet caught, so no ADC reads are needed.
+ * Call update() after Pots::scan().
+ */
+class PotBank {
+	public:
+	static constexpr uint8_t kMaxPages = 8;
+	static constexpr uint16_t kDefaultPickupWindow = 2;
+
+	/**
+	 * @brief Attach to pots and clear all pages
+	 *
+	 * @param pots Initialized Pots instance (must outlive this object)
+	 * @param num_pages Number of pages (1-kMaxPages)
+	 * @return false if pots is null or num_pages is out of range
+	 */
+	bool init(Pots* pots, uint8_t num_pages);
+
+	/**
+	 * @brief Set takeover mode of one pot on all pages
+	 *
+	 * @param pot Logical pot index
+	 * @param mode Takeover mode (default kPotModePickup)
+	 */
+	void set_mode(uint8_t pot, PotBankMode mode);
+
+	/**
+	 * @brief Distance at which pickup mode catches the stored value
+	 *
+	 * @param window Distance in output units
+	 */
+	void set_pickup_window(uint16_t window);
+
+	/**
+	 * @brief Switch the page the pots edit
+	 *
+	 * @param page Page index (0 to num_pages-1)
+	 */
+	void set_page(uint8_t page);
+	uint8_t get_page() const;
+
+	/**
+	 * @brief Apply pot movement to the current page
+	 *
+	 * Reads the Pots values (cached in incremental and background modes)
+	 * and fires the change callback for every value that changed.
+	 */
+	void update();
+
+	/**
+	 * @brief Get a value of the current page
+	 *
+	 * @param pot Logical pot index
+	 * @return Stored value, 0 for invalid index
+	 */
+	uint16_t get(uint8_t pot) const;
+
+	/**
+	 * @brief Get a value of any page
+	 *
+	 * @param page Page index
+	 * @param pot Logical pot index
+	 * @return Stored value, 0 for invalid index
+	 */
+	uint16_t get(uint8_t page, uint8_t pot) const;
+
+	/**
+	 * @brief Store a value, e.g. when loading a preset
+	 *
+	 * On the current page the pot has to take over again.
+	 *
+	 * @param page Page index
+	 * @param pot Logical pot index
+	 * @param value Value in output units, clamped to the Pots range
+	 */
+	void set(uint8_t page, uint8_t pot, uint16_t value);
+
+	/**
+	 * @brief Whether the pot currently controls its value on this page
+	 *
+	 * Useful for LED feedback while a pickup or scale takeover is pending.
+	 */
+	bool is_caught(uint8_t pot) const;
+
+	/**
+	 * @brief Set callback for value changes
+	 *
+	 * @param cb Callback function: void(uint8_t page, uint8_t pot, uint16_t value)
+	 */
+	void set_on_change(brain::utils::Delegate<void(uint8_t, uint8_t, uint16_t)> cb);
+
+	private:
+	uint16_t apply(uint8_t pot, uint16_t value, uint16_t last, uint16_t now);
+
+	Pots* pots_ = nullptr;
+	uint8_t num_pages_ = 0;
+	uint8_t num_pots_ = 0;
+	uint8_t page_ = 0;
+	uint16_t max_value_ = 0;
+	uint16_t pickup_window_ = kDefaultPickupWindow;
+	uint8_t caught_ = 0;  ///< Bit per pot, cleared on page switch
+	PotBankMode modes_[kMaxPots] = {kPotModePickup, kPotModePickup, kPotModePickup,
+		kPotModePickup};
+	uint16_t last_physical_[kMaxPots] = {0, 0, 0, 0};
+	uint16_t values_[kMaxPages][kMaxPots] = {};
+	brain::utils::Delegate<void(uint8_t, uint8_t, uint16_t)> on_change_;
+};
+
+}  // namespace brain::ui
+
+#endif	// BRAIN_UI_POT_BANK_H_
@@ -3,13 +3,48 @@
 #pragma once
 
 #include <cstdint>
-#include <functional>
 
 #include "brain-common/brain-gpio-setup.h"
+#include "brain-utils/delegate.h"
+#include "brain-utils/smoothing-filter.h"
+#include "pico/time.h"
+
+namespace brain::io {
+class AdcScheduler;
+}
 
 namespace brain::ui {
 
 static constexpr uint8_t kMaxPots = 4;	// 4-channel multiplexer
+static constexpr uint8_t kMaxOutputResolution = 14;	 // Needs smoothing for more than 12 bits
+
+/**
+ * @brief How scan() reads the potentiometers
+ */
+enum PotsScanMode {
+	kScanBlocking = 0,	///< Read every pot on each scan(), waiting for the mux to settle
+	kScanIncremental = 1,  ///< Read at most one settled pot per scan(), never wait
+	kScanBackground = 2,  ///< Repeating timer and DMA read pots, scan() only reports changes
+};
+
+/**
+ * @brief Transfer curve applied to a pot reading
+ */
+enum PotCurve {
+	kCurveLinear = 0,
+	kCurveLog = 1,	///< Fast rise at the start of the travel, ln(1 + 20x) / ln(21)
+	kCurveExp = 2,	///< Slow start, fast end, the inverse of kCurveLog
+	kCurveCenterDetent = 3,	 ///< Flat zone around the center, linear on both sides
+	kCurveCustom = 4,  ///< Piecewise linear through points from set_curve_points()
+};
+
+/**
+ * @brief Breakpoint of a custom curve, both values in 12-bit units (0-4095)
+ */
+struct PotCurvePoint {
+	uint16_t in;
+	uint16_t out;
+};
 
 /**
  * @brief Configuration structure for PotMultiplexer
@@ -24,10 +59,13 @@ struct PotsConfig {
 	uint8_t s1_gpio;  ///< Multiplexer S1 select line GPIO
 	uint8_t num_pots;  ///< Number of active potentiometers (1-4)
 	uint8_t channel_map[kMaxPots];	///< Logical-to-physical channel mapping
-	uint8_t output_resolution;	///< Output resolution in bits (e.g., 7 for 0-127)
+	uint8_t output_resolution;	///< Output resolution in bits (1-14, e.g., 7 for 0-127)
 	uint32_t settling_delay_us;	 ///< Settling time after mux channel change (µs)
 	uint8_t samples_per_read;  ///< Number of samples to average per reading
 	uint16_t change_threshold;	///< Minimum change to trigger callback
+	PotsScanMode scan_mode;	 ///< Blocking (default), incremental or background scanning
+	bool smoothing;	 ///< Adaptive filter on single samples instead of averaged bursts (default off)
+	PotCurve curves[kMaxPots];	///< Transfer curve per logical pot
 };
 
 /**
@@ -61,6 +99,11 @@ class Pots {
 	 */
 	Pots();
 
+	/**
+	 * @brief Stops background acquisition if it is running
+	 */
+	~Pots();
+
 	/**
 	 * @brief Initialize hardware and configure multiplexer
 	 *
@@ -71,6 +114,19 @@ class Pots {
 	 */
 	void init(const PotsConfig& cfg);
 
+	/**
+	 * @brief Initialize for reading through a shared ADC scheduler
+	 *
+	 * The scheduler owns the ADC and the mux select lines, so no hardware is
+	 * touched here. Readings never block; timing and averaging config fields
+	 * are ignored since the scheduler settles and averages on its own. The
+	 * scheduler is set to scan the physical channels in channel_map.
+	 *
+	 * @param cfg Configuration structure (num_pots, channel_map, resolution, threshold)
+	 * @param scheduler Running scheduler that owns the ADC (must outlive this object)
+	 */
+	void init(const PotsConfig& cfg, brain::io::AdcScheduler* scheduler);
+
 	/**
 	 * Config setters
 	 */
@@ -79,6 +135,54 @@ class Pots {
 	void set_settling_delay_us(uint32_t delay);
 	void set_samples_per_read(uint8_t samples);
 	void set_change_threshold (uint16_t threshold);
+	void set_scan_mode(PotsScanMode mode);
+
+	/**
+	 * @brief Enable the adaptive smoothing filter
+	 *
+	 * Only applies to kScanIncremental and kScanBackground modes. Each
+	 * settled pot is then read with a single conversion and fed through a
+	 * brain::utils::SmoothingFilter; samples_per_read is ignored.
+	 */
+	void set_smoothing(bool smoothing);
+
+	/**
+	 * @brief Tune the smoothing filter of every pot
+	 *
+	 * @see brain::utils::SmoothingFilter::set_params
+	 */
+	void set_smoothing_params(uint16_t min_alpha, uint8_t sensitivity_shift, uint16_t deadband);
+
+	/**
+	 * @brief Set the transfer curve of a pot
+	 *
+	 * The curve is compiled into a lookup table here, readings then only
+	 * cost one interpolated table lookup. Applies to get(), get_hires(),
+	 * get_dac_code() and the change callback, not to get_raw().
+	 *
+	 * @param index Logical potentiometer index
+	 * @param curve Curve type, kCurveCustom needs set_curve_points() instead
+	 */
+	void set_curve(uint8_t index, PotCurve curve);
+
+	/**
+	 * @brief Set a custom piecewise linear curve for a pot
+	 *
+	 * Inputs before the first and after the last point keep the output of
+	 * that point. The points are only used to build the table.
+	 *
+	 * @param index Logical potentiometer index
+	 * @param points Breakpoints with strictly increasing in values
+	 * @param count Number of points (at least 2)
+	 * @return false if the index or points are invalid
+	 */
+	bool set_curve_points(uint8_t index, const PotCurvePoint* points, uint8_t count);
+
+	/**
+	 * Config getters
+	 */
+	uint8_t get_num_pots() const;
+	uint8_t get_output_resolution() const;
 
 	/**
 	 * @brief Scan all configured potentiometers for changes
@@ -86,6 +190,14 @@ class Pots {
 	 * Reads all active channels and triggers callbacks for values that
 	 * have changed beyond the configured threshold. Call regularly in
 	 * main loop for responsive UI updates.
+	 *
+	 * In kScanIncremental mode this returns immediately until the mux has
+	 * settled on the current pot, then reads that pot (a few µs of ADC
+	 * conversions), moves the mux to the next pot and returns.
+	 *
+	 * In kScanBackground mode this only compares the published snapshot
+	 * against the last reported values, so callbacks still run here rather
+	 * than in interrupt context.
 	 */
 	void scan();
 
@@ -94,7 +206,8 @@ class Pots {
 	 *
 	 * Returns the current value scaled to the configured output resolution.
 	 * For example, with 7-bit resolution, returns 0-127 regardless of
-	 * the 12-bit ADC input range.
+	 * the 12-bit ADC input range. In kScanIncremental and kScanBackground
+	 * modes this is the latest published value and doesn't touch the ADC.
 	 *
 	 * @param index Logical potentiometer index (0 to num_pots-1)
 	 * @return Scaled value, or 0 if index is invalid
@@ -105,13 +218,37 @@ class Pots {
 	 * @brief Get raw 12-bit ADC value
 	 *
 	 * Returns the unscaled ADC reading (0-4095) for debugging or
-	 * applications requiring full resolution.
+	 * applications requiring full resolution. Cached in kScanIncremental and
+	 * kScanBackground modes.
 	 *
 	 * @param index Logical potentiometer index (0 to num_pots-1)
 	 * @return Raw ADC value (0-4095), or 0 if index is invalid
 	 */
 	uint16_t get_raw(uint8_t index);
 
+	/**
+	 * @brief Get full-precision potentiometer value
+	 *
+	 * The 12-bit reading with 4 fraction bits (0-65520). With smoothing
+	 * enabled the fraction bits come from averaging dithered samples over
+	 * time, giving up to 14 effective bits; otherwise they are zero.
+	 *
+	 * @param index Logical potentiometer index (0 to num_pots-1)
+	 * @return Value scaled by 16, or 0 if index is invalid
+	 */
+	uint16_t get_hires(uint8_t index);
+
+	/**
+	 * @brief Get value as a 12-bit DAC code
+	 *
+	 * Rounded from the full-precision value, ready for
+	 * AudioCvOut::set_dac_value().
+	 *
+	 * @param index Logical potentiometer index (0 to num_pots-1)
+	 * @return DAC code (0-4095), or 0 if index is invalid
+	 */
+	uint16_t get_dac_code(uint8_t index);
+
 	/**
 	 * @brief Set callback for potentiometer value changes
 	 *
@@ -120,9 +257,22 @@ class Pots {
 	 *
 	 * @param cb Callback function: void(uint8_t pot_index, uint16_t new_value)
 	 */
-	void set_on_change(std::function<void(uint8_t, uint16_t)> cb);
+	void set_on_change(brain::utils::Delegate<void(uint8_t, uint16_t)> cb);
 
 	private:
+	static constexpr uint8_t kDiscardSamples = 3;
+	static constexpr uint8_t kMaxCaptureSamples = 16;  ///< Averaged samples per DMA capture
+
+	/**
+	 * @brief Latest reading of every pot, 12-bit with 4 fraction bits
+	 *
+	 * Two copies are kept: the writer fills the back copy and then flips
+	 * published_, so readers always see a complete set.
+	 */
+	struct Snapshot {
+		volatile uint16_t value[kMaxPots];
+	};
+
 	/**
 	 * @brief Set multiplexer channel selection
 	 *
@@ -138,9 +288,92 @@ class Pots {
 	 */
 	uint16_t read_channel_once(uint8_t ch);
 
+	/**
+	 * @brief Take discard and averaged samples from the selected mux channel
+	 *
+	 * No delays, assumes the mux output has already settled.
+	 */
+	uint16_t sample_selected_channel();
+
+	/**
+	 * @brief Advance the incremental scanner by at most one pot
+	 */
+	void scan_incremental();
+
+	/**
+	 * @brief Move the incremental scanner to a pot and start its settling time
+	 *
+	 * @param index Logical potentiometer index
+	 */
+	void select_scan_index(uint8_t index);
+
+	/**
+	 * @brief Read every pot once into the snapshot and restart the scanner
+	 */
+	void prime_snapshot();
+
+	/**
+	 * @brief Claim a DMA channel and start the repeating acquisition timer
+	 *
+	 * @return false if no DMA channel or timer is available
+	 */
+	bool start_background();
+	void stop_background();
+
+	/**
+	 * @brief Repeating timer callback, alternates between starting a DMA
+	 * capture on the settled pot and collecting it and moving the mux
+	 */
+	static bool background_timer_callback(repeating_timer_t* rt);
+	void background_tick();
+	void start_capture();
+	bool collect_capture(uint16_t* result);
+
+	uint32_t settling_us() const;
+	bool uses_snapshot() const;
+	bool single_sample() const;
+	void publish_raw(uint8_t index, uint16_t raw);
+
+	/**
+	 * @brief Reading with 4 fraction bits, from the snapshot or the ADC
+	 */
+	uint16_t read_value(uint8_t index);
+
+	/**
+	 * @brief Map a full-precision value through the pot's curve table
+	 */
+	uint16_t apply_curve(uint8_t index, uint16_t value) const;
+
+	/**
+	 * @brief Precompute the multiplier scale() uses for output_resolution
+	 */
+	void update_scale();
+	uint16_t scale(uint16_t value) const;
+	void check_change(uint8_t index, uint16_t val);
+
 	PotsConfig config_;  ///< Hardware configuration
+	uint32_t scale_mult_ = 0;	///< Output range per full-precision step, in 1/65536
+	brain::io::AdcScheduler* scheduler_ = nullptr;  ///< Shared ADC owner, if any
 	uint16_t last_values_[kMaxPots];  ///< Last known values for change detection
-	std::function<void(uint8_t, uint16_t)> on_change_;	///< Change callback function
+	brain::utils::SmoothingFilter filters_[kMaxPots];	///< Per-pot smoothing
+
+	// Curve tables with kCurveSegments + 1 points over the full-precision range
+	static constexpr uint8_t kCurveSegmentBits = 6;
+	static constexpr uint8_t kCurveSegments = 1 << kCurveSegmentBits;
+	uint16_t curve_tables_[kMaxPots][kCurveSegments + 1];
+	Snapshot snapshots_[2];	 ///< Published readings (incremental and background modes)
+	volatile uint8_t published_ = 0;	///< Index of the snapshot readers use
+	uint8_t scan_index_ = 0;	///< Pot the mux is settling on
+	uint32_t mux_switched_us_ = 0;	///< When the mux was last moved (incremental mode)
+
+	// Background mode
+	repeating_timer_t timer_;
+	bool background_running_ = false;
+	volatile bool capture_running_ = false;
+	int dma_channel_ = -1;
+	uint8_t capture_count_ = 0;
+	uint16_t capture_buffer_[kDiscardSamples + kMaxCaptureSamples];
+	brain::utils::Delegate<void(uint8_t, uint16_t)> on_change_;	///< Change callback function
 };
 
 }  // namespace brain::ui
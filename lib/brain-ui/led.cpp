@@ -129,11 +129,11 @@ bool Led::is_blinking() const {
 	return blinking_;
 }
 
-void Led::set_on_state_change(std::function<void(bool)> callback) {
+void Led::set_on_state_change(brain::utils::Delegate<void(bool)> callback) {
 	on_state_change_ = callback;
 }
 
-void Led::set_on_blink_end(std::function<void()> callback) {
+void Led::set_on_blink_end(brain::utils::Delegate<void()> callback) {
 	on_blink_end_ = callback;
 }
 
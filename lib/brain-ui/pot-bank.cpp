@@ -0,0 +1,141 @@
+#include "brain-ui/pot-bank.h"
+
+namespace brain::ui {
+
+bool PotBank::init(Pots* pots, uint8_t num_pages) {
+	if (pots == nullptr || num_pages == 0 || num_pages > kMaxPages) {
+		return false;
+	}
+
+	pots_ = pots;
+	num_pages_ = num_pages;
+	num_pots_ = pots->get_num_pots();
+	max_value_ = (1u << pots->get_output_resolution()) - 1;
+	page_ = 0;
+	caught_ = 0;
+
+	for (uint8_t page = 0; page < kMaxPages; ++page) {
+		for (uint8_t pot = 0; pot < kMaxPots; ++pot) {
+			values_[page][pot] = 0;
+		}
+	}
+	for (uint8_t pot = 0; pot < num_pots_; ++pot) {
+		last_physical_[pot] = pots->get(pot);
+	}
+
+	return true;
+}
+
+void PotBank::set_mode(uint8_t pot, PotBankMode mode) {
+	if (pot >= kMaxPots) return;
+	modes_[pot] = mode;
+	caught_ &= ~(1u << pot);
+}
+
+void PotBank::set_pickup_window(uint16_t window) {
+	pickup_window_ = window;
+}
+
+void PotBank::set_page(uint8_t page) {
+	if (page >= num_pages_ || page == page_) return;
+
+	page_ = page;
+	caught_ = 0;
+}
+
+uint8_t PotBank::get_page() const {
+	return page_;
+}
+
+uint16_t PotBank::apply(uint8_t pot, uint16_t value, uint16_t last, uint16_t now) {
+	uint8_t mask = 1u << pot;
+	int32_t v = value;
+
+	switch (modes_[pot]) {
+		case kPotModeJump:
+			caught_ |= mask;
+			break;
+
+		case kPotModePickup: {
+			// Caught once the pot passes the stored value, or gets close to it
+			uint16_t low = last < now ? last : now;
+			uint16_t high = last < now ? now : last;
+			int32_t distance = static_cast<int32_t>(now) - v;
+			bool crossed = v >= low && v <= high;
+			if (crossed || (distance <= pickup_window_ && -distance <= pickup_window_)) {
+				caught_ |= mask;
+			}
+			break;
+		}
+
+		case kPotModeScale:
+			if (caught_ & mask) break;
+
+			// Cover the remaining range in the same travel the pot has left, so
+			// both meet at the end of the pot
+			if (now > last && v < max_value_) {
+				v += (static_cast<int32_t>(now - last) * (max_value_ - v)) / (max_value_ - last);
+			} else if (now < last && v > 0) {
+				v -= (static_cast<int32_t>(last - now) * v) / last;
+			}
+			if (v == now) caught_ |= mask;
+			return static_cast<uint16_t>(v);
+
+		case kPotModeRelative:
+			v += static_cast<int32_t>(now) - last;
+			if (v < 0) v = 0;
+			if (v > max_value_) v = max_value_;
+			return static_cast<uint16_t>(v);
+	}
+
+	return (caught_ & mask) ? now : value;
+}
+
+void PotBank::update() {
+	if (pots_ == nullptr) return;
+
+	for (uint8_t pot = 0; pot < num_pots_; ++pot) {
+		uint16_t now = pots_->get(pot);
+		uint16_t last = last_physical_[pot];
+		if (now == last) continue;
+		last_physical_[pot] = now;
+
+		uint16_t value = values_[page_][pot];
+		uint16_t updated = apply(pot, value, last, now);
+		if (updated == value) continue;
+
+		values_[page_][pot] = updated;
+		if (on_change_) {
+			on_change_(page_, pot, updated);
+		}
+	}
+}
+
+uint16_t PotBank::get(uint8_t pot) const {
+	return get(page_, pot);
+}
+
+uint16_t PotBank::get(uint8_t page, uint8_t pot) const {
+	if (page >= num_pages_ || pot >= num_pots_) return 0;
+	return values_[page][pot];
+}
+
+void PotBank::set(uint8_t page, uint8_t pot, uint16_t value) {
+	if (page >= num_pages_ || pot >= num_pots_) return;
+
+	values_[page][pot] = value > max_value_ ? max_value_ : value;
+	if (page == page_) {
+		caught_ &= ~(1u << pot);
+	}
+}
+
+bool PotBank::is_caught(uint8_t pot) const {
+	if (pot >= num_pots_) return false;
+	return (caught_ & (1u << pot)) != 0;
+}
+
+void PotBank::set_on_change(brain::utils::Delegate<void(uint8_t, uint8_t, uint16_t)> cb) {
+	on_change_ = cb;
+}
+
+}  // namespace brain::ui
@@ -4,13 +4,60 @@
 #include "brain-ui/pots.h"
 
 #include <hardware/adc.h>
+#include <hardware/dma.h>
 #include <hardware/gpio.h>
 #include <pico/stdlib.h>
 
+#include <cmath>
+#include <cstdio>
+
 #include "brain-common/brain-gpio-setup.h"
+#include "brain-io/adc-scheduler.h"
 
 namespace brain::ui {
 
+static constexpr uint32_t kMinSettlingDelayUs = 100;
+static constexpr uint8_t kFractionBits = brain::utils::SmoothingFilter::kFractionBits;
+static constexpr uint16_t kMaxValue = brain::utils::SmoothingFilter::kMaxValue;	// 4095 << 4
+
+static constexpr float kCurveLogAmount = 20.0f;
+static constexpr uint16_t kCenterDetentWidth = kMaxValue / 32;	// Each side, ~3% of travel
+
+/**
+ * Evaluate an analytic curve at a full-precision input (0-kMaxValue).
+ * Only used while building tables, so float math is fine here.
+ */
+static uint16_t evaluate_curve(PotCurve curve, uint32_t x) {
+	float t = static_cast<float>(x) / kMaxValue;
+	float y = t;
+
+	switch (curve) {
+		case kCurveLog:
+			y = logf(1.0f + kCurveLogAmount * t) / logf(1.0f + kCurveLogAmount);
+			break;
+		case kCurveExp:
+			y = (powf(1.0f + kCurveLogAmount, t) - 1.0f) / kCurveLogAmount;
+			break;
+		case kCurveCenterDetent: {
+			uint32_t center = kMaxValue / 2;
+			if (x + kCenterDetentWidth < center) {
+				return x * center / (center - kCenterDetentWidth);
+			}
+			if (x <= center + kCenterDetentWidth) {
+				return center;
+			}
+			uint32_t start = center + kCenterDetentWidth;
+			return center + (x - start) * (kMaxValue - center) / (kMaxValue - start);
+		}
+		default:
+			return x;
+	}
+
+	if (y < 0.0f) y = 0.0f;
+	if (y > 1.0f) y = 1.0f;
+	return static_cast<uint16_t>(y * kMaxValue + 0.5f);
+}
+
 PotsConfig create_default_config(uint8_t num_pots, uint8_t output_resolution) {
 	PotsConfig cfg = {};
 	cfg.simple = false;
@@ -25,21 +72,41 @@ PotsConfig create_default_config(uint8_t num_pots, uint8_t output_resolution) {
 	cfg.settling_delay_us = 200;  // Reasonable default for 74HC4051
 	cfg.samples_per_read = 6;  // Good balance of stability vs speed
 	cfg.change_threshold = 1;  // Sensitive change detection
+	cfg.scan_mode = kScanBlocking;  // get() reads the ADC, opt in to incremental/background
+	cfg.smoothing = false;  // Averaged bursts, opt in to the adaptive filter
+	for (int i = 0; i < kMaxPots; ++i) {
+		cfg.curves[i] = kCurveLinear;
+	}
 	return cfg;
 }
 
 Pots::Pots() {
 	for (int i = 0; i < kMaxPots; ++i) {
 		last_values_[i] = 0;
+		snapshots_[0].value[i] = 0;
+		snapshots_[1].value[i] = 0;
+	}
+}
+
+Pots::~Pots() {
+	stop_background();
+	if (dma_channel_ >= 0) {
+		dma_channel_unclaim(dma_channel_);
 	}
 }
 
 void Pots::init(const PotsConfig& cfg) {
+	stop_background();
+	scheduler_ = nullptr;
 	config_ = cfg;
 	// Ensure num_pots doesn't exceed our array size
 	if (config_.num_pots > kMaxPots) {
 		config_.num_pots = kMaxPots;
 	}
+	update_scale();
+	for (uint8_t i = 0; i < kMaxPots; ++i) {
+		set_curve(i, config_.curves[i]);
+	}
 
 	adc_init();
 	gpio_init(cfg.s0_gpio);
@@ -53,6 +120,35 @@ void Pots::init(const PotsConfig& cfg) {
 	adc_select_input(cfg.adc_gpio - 26);
 	// Small guard delay
 	busy_wait_us_32(cfg.settling_delay_us);
+
+	// Start with valid cached values, then keep them fresh from scan() or the timer
+	if (config_.scan_mode != kScanBlocking) {
+		prime_snapshot();
+	}
+
+	if (config_.scan_mode == kScanBackground && !start_background()) {
+		config_.scan_mode = kScanIncremental;
+	}
+}
+
+void Pots::init(const PotsConfig& cfg, brain::io::AdcScheduler* scheduler) {
+	stop_background();
+	config_ = cfg;
+	if (config_.num_pots > kMaxPots) {
+		config_.num_pots = kMaxPots;
+	}
+	update_scale();
+	for (uint8_t i = 0; i < kMaxPots; ++i) {
+		set_curve(i, config_.curves[i]);
+	}
+
+	// adc_init() would reset the running scheduler, the ADC is already set up
+	scheduler_ = scheduler;
+
+	// Scan the mapped physical channels, reads go by physical channel
+	if (scheduler_ != nullptr && config_.num_pots > 0) {
+		scheduler_->set_pot_channels(config_.channel_map, config_.num_pots);
+	}
 }
 
 void Pots::set_simple(bool simple) {
@@ -61,6 +157,7 @@ void Pots::set_simple(bool simple) {
 
 void Pots::set_output_resolution(uint8_t resolution) {
 	config_.output_resolution = resolution;
+	update_scale();
 }
 
 void Pots::set_settling_delay_us(uint32_t delay) {
@@ -75,6 +172,117 @@ void Pots::set_change_threshold (uint16_t threshold) {
 	config_.change_threshold = threshold;
 }
 
+void Pots::set_scan_mode(PotsScanMode mode) {
+	if (mode == config_.scan_mode) return;
+
+	stop_background();
+	PotsScanMode previous = config_.scan_mode;
+	config_.scan_mode = mode;
+
+	// Blocking reads never fill the snapshot, start from valid values
+	if (mode != kScanBlocking && scheduler_ == nullptr) {
+		if (previous == kScanBlocking) {
+			prime_snapshot();
+		} else {
+			select_scan_index(0);
+		}
+	}
+
+	if (mode == kScanBackground && scheduler_ == nullptr && !start_background()) {
+		config_.scan_mode = kScanIncremental;
+	}
+}
+
+void Pots::set_smoothing(bool smoothing) {
+	if (smoothing && !config_.smoothing) {
+		// Continue from the published values instead of ramping up from zero
+		for (uint8_t i = 0; i < kMaxPots; ++i) {
+			filters_[i].reset(snapshots_[published_].value[i] >> kFractionBits);
+		}
+	}
+	config_.smoothing = smoothing;
+}
+
+void Pots::set_smoothing_params(uint16_t min_alpha, uint8_t sensitivity_shift, uint16_t deadband) {
+	for (uint8_t i = 0; i < kMaxPots; ++i) {
+		filters_[i].set_params(min_alpha, sensitivity_shift, deadband);
+	}
+}
+
+void Pots::set_curve(uint8_t index, PotCurve curve) {
+	if (index >= kMaxPots) return;
+
+	// Custom curves only come from set_curve_points()
+	if (curve == kCurveCustom) curve = kCurveLinear;
+	config_.curves[index] = curve;
+	if (curve == kCurveLinear) return;
+
+	for (uint8_t i = 0; i <= kCurveSegments; ++i) {
+		uint32_t x = static_cast<uint32_t>(i) * kMaxValue / kCurveSegments;
+		curve_tables_[index][i] = evaluate_curve(curve, x);
+	}
+}
+
+bool Pots::set_curve_points(uint8_t index, const PotCurvePoint* points, uint8_t count) {
+	if (index >= kMaxPots || points == nullptr || count < 2) return false;
+	for (uint8_t p = 0; p < count; ++p) {
+		if (points[p].in > 4095 || points[p].out > 4095) return false;
+		if (p > 0 && points[p].in <= points[p - 1].in) return false;
+	}
+
+	uint8_t p = 0;
+	for (uint8_t i = 0; i <= kCurveSegments; ++i) {
+		uint32_t x = static_cast<uint32_t>(i) * kMaxValue / kCurveSegments;
+		uint32_t first = points[0].in << kFractionBits;
+		uint32_t last = points[count - 1].in << kFractionBits;
+
+		uint32_t y;
+		if (x <= first) {
+			y = points[0].out << kFractionBits;
+		} else if (x >= last) {
+			y = points[count - 1].out << kFractionBits;
+		} else {
+			while ((points[p + 1].in << kFractionBits) < x) p++;
+			int32_t x0 = points[p].in << kFractionBits;
+			int32_t x1 = points[p + 1].in << kFractionBits;
+			int32_t y0 = points[p].out << kFractionBits;
+			int32_t y1 = points[p + 1].out << kFractionBits;
+			// Both factors reach ~65520, the product needs 64 bits
+			int64_t dy = static_cast<int64_t>(y1 - y0) * (static_cast<int32_t>(x) - x0);
+			y = static_cast<uint32_t>(y0 + static_cast<int32_t>(dy / (x1 - x0)));
+		}
+		curve_tables_[index][i] = static_cast<uint16_t>(y);
+	}
+
+	config_.curves[index] = kCurveCustom;
+	return true;
+}
+
+uint16_t Pots::apply_curve(uint8_t index, uint16_t value) const {
+	if (config_.curves[index] == kCurveLinear) return value;
+
+	const uint16_t* table = curve_tables_[index];
+	if (value >= kMaxValue) return table[kCurveSegments];
+
+	// Position in 1/1024 segments, value * 65536 / 65520 without dividing
+	static constexpr uint8_t kSegmentFractionBits = 16 - kCurveSegmentBits;
+	uint32_t position = value + (value >> 12);
+	uint32_t segment = position >> kSegmentFractionBits;
+	int32_t fraction = position & ((1u << kSegmentFractionBits) - 1);
+
+	int32_t y0 = table[segment];
+	int32_t y1 = table[segment + 1];
+	return static_cast<uint16_t>(y0 + (((y1 - y0) * fraction) >> kSegmentFractionBits));
+}
+
+uint8_t Pots::get_num_pots() const {
+	return config_.num_pots;
+}
+
+uint8_t Pots::get_output_resolution() const {
+	return config_.output_resolution;
+}
+
 void Pots::set_mux_channel(uint8_t ch) {
 	ch &= 0x03;
 	gpio_put(config_.s0_gpio, ch & 0x01);
@@ -82,6 +290,11 @@ void Pots::set_mux_channel(uint8_t ch) {
 }
 
 uint16_t Pots::read_channel_once(uint8_t ch) {
+	// The scheduler has already settled and averaged this channel
+	if (scheduler_ != nullptr) {
+		return scheduler_->get_pot_raw(ch);
+	}
+
 	set_mux_channel(ch);
 
 	// Reselect ADC input to ensure proper synchronization
@@ -94,10 +307,11 @@ uint16_t Pots::read_channel_once(uint8_t ch) {
 		return adc_value;
 
 	} else {
-		busy_wait_us_32(config_.settling_delay_us > 100 ? config_.settling_delay_us : 100);
+		busy_wait_us_32(config_.settling_delay_us > kMinSettlingDelayUs ? config_.settling_delay_us
+																		: kMinSettlingDelayUs);
 
 		// Discard multiple samples to ensure ADC has settled
-		for (int i = 0; i < 3; i++) {
+		for (int i = 0; i < kDiscardSamples; i++) {
 			(void) adc_read();
 		}
 
@@ -113,37 +327,256 @@ uint16_t Pots::read_channel_once(uint8_t ch) {
 	}
 }
 
+uint16_t Pots::sample_selected_channel() {
+	// Another component may have moved the ADC input since the last read
+	adc_select_input(config_.adc_gpio - 26);
+
+	if (single_sample()) {
+		return adc_read();
+	}
+
+	for (int i = 0; i < kDiscardSamples; i++) {
+		(void) adc_read();
+	}
+
+	// Conversions take 2µs each, so spacing them out would only add latency
+	uint32_t sum = 0;
+	uint8_t samples = config_.samples_per_read > 0 ? config_.samples_per_read : 1;
+	for (uint8_t i = 0; i < samples; ++i) {
+		sum += adc_read();
+	}
+	return sum / samples;
+}
+
+void Pots::prime_snapshot() {
+	for (uint8_t i = 0; i < config_.num_pots; ++i) {
+		uint16_t raw = read_channel_once(config_.channel_map[i]);
+		filters_[i].reset(raw);
+		publish_raw(i, raw);
+	}
+	select_scan_index(0);
+}
+
+void Pots::select_scan_index(uint8_t index) {
+	scan_index_ = index;
+	set_mux_channel(config_.channel_map[index]);
+	mux_switched_us_ = time_us_32();
+}
+
+void Pots::scan_incremental() {
+	if (config_.num_pots == 0) return;
+
+	if (time_us_32() - mux_switched_us_ < settling_us()) {
+		return;
+	}
+
+	uint8_t index = scan_index_;
+	publish_raw(index, sample_selected_channel());
+
+	// Move on right away so the next pot settles while the main loop runs
+	select_scan_index(index + 1 < config_.num_pots ? index + 1 : 0);
+
+	check_change(index, get(index));
+}
+
+uint32_t Pots::settling_us() const {
+	// Simple mode never waited for the mux, keep it that way
+	if (config_.simple) return 0;
+	return config_.settling_delay_us > kMinSettlingDelayUs ? config_.settling_delay_us
+														   : kMinSettlingDelayUs;
+}
+
+bool Pots::uses_snapshot() const {
+	return config_.scan_mode != kScanBlocking && scheduler_ == nullptr;
+}
+
+bool Pots::single_sample() const {
+	return config_.simple || config_.smoothing;
+}
+
+void Pots::publish_raw(uint8_t index, uint16_t raw) {
+	uint16_t value = config_.smoothing ? filters_[index].process(raw) : raw << kFractionBits;
+
+	uint8_t front = published_;
+	uint8_t back = front ^ 1;
+	for (uint8_t i = 0; i < kMaxPots; ++i) {
+		snapshots_[back].value[i] = snapshots_[front].value[i];
+	}
+	snapshots_[back].value[index] = value;
+	published_ = back;
+}
+
+bool Pots::start_background() {
+	if (config_.num_pots == 0) return false;
+
+	if (dma_channel_ < 0) {
+		dma_channel_ = dma_claim_unused_channel(false);
+		if (dma_channel_ < 0) {
+			fprintf(stderr, "Pots: No free DMA channel for background scanning\n");
+			return false;
+		}
+	}
+
+	uint8_t samples = config_.samples_per_read > 0 ? config_.samples_per_read : 1;
+	if (samples > kMaxCaptureSamples) samples = kMaxCaptureSamples;
+	capture_count_ = single_sample() ? 1 : kDiscardSamples + samples;
+	capture_running_ = false;
+	select_scan_index(0);
+
+	// Each tick either starts a capture on a settled pot or collects it and
+	// moves the mux, so the tick period doubles as the settling time
+	uint32_t period_us = settling_us() > kMinSettlingDelayUs ? settling_us() : kMinSettlingDelayUs;
+	if (!add_repeating_timer_us(-static_cast<int64_t>(period_us), &Pots::background_timer_callback,
+			this, &timer_)) {
+		fprintf(stderr, "Pots: No free alarm for background scanning\n");
+		return false;
+	}
+
+	background_running_ = true;
+	return true;
+}
+
+void Pots::stop_background() {
+	if (!background_running_) return;
+
+	cancel_repeating_timer(&timer_);
+	background_running_ = false;
+
+	if (capture_running_) {
+		adc_run(false);
+		dma_channel_abort(dma_channel_);
+		adc_fifo_setup(false, false, 0, false, false);
+		adc_fifo_drain();
+		capture_running_ = false;
+	}
+}
+
+bool Pots::background_timer_callback(repeating_timer_t* rt) {
+	static_cast<Pots*>(rt->user_data)->background_tick();
+	return true;
+}
+
+void Pots::background_tick() {
+	if (!capture_running_) {
+		start_capture();
+		return;
+	}
+
+	uint16_t raw;
+	if (!collect_capture(&raw)) {
+		return;  // Still converting, try again next tick
+	}
+
+	publish_raw(scan_index_, raw);
+	select_scan_index(scan_index_ + 1 < config_.num_pots ? scan_index_ + 1 : 0);
+}
+
+void Pots::start_capture() {
+	adc_select_input(config_.adc_gpio - 26);
+	adc_fifo_setup(true, true, 1, false, false);
+	adc_fifo_drain();
+
+	dma_channel_config c = dma_channel_get_default_config(dma_channel_);
+	channel_config_set_transfer_data_size(&c, DMA_SIZE_16);
+	channel_config_set_read_increment(&c, false);
+	channel_config_set_write_increment(&c, true);
+	channel_config_set_dreq(&c, DREQ_ADC);
+	dma_channel_configure(dma_channel_, &c, capture_buffer_, &adc_hw->fifo, capture_count_, true);
+
+	capture_running_ = true;
+	adc_run(true);
+}
+
+bool Pots::collect_capture(uint16_t* result) {
+	if (dma_channel_is_busy(dma_channel_)) {
+		return false;
+	}
+
+	adc_run(false);
+	adc_fifo_setup(false, false, 0, false, false);
+	adc_fifo_drain();
+	capture_running_ = false;
+
+	uint8_t first = capture_count_ > kDiscardSamples ? kDiscardSamples : 0;
+	uint32_t sum = 0;
+	for (uint8_t i = first; i < capture_count_; ++i) {
+		sum += capture_buffer_[i];
+	}
+	*result = sum / (capture_count_ - first);
+	return true;
+}
+
+uint16_t Pots::read_value(uint8_t index) {
+	if (uses_snapshot()) {
+		return snapshots_[published_].value[index];
+	}
+	return read_channel_once(config_.channel_map[index]) << kFractionBits;
+}
+
 uint16_t Pots::get_raw(uint8_t index) {
 	if (index >= config_.num_pots || index >= kMaxPots) return 0;
-	return read_channel_once(config_.channel_map[index]);
+	return read_value(index) >> kFractionBits;
 }
 
-uint16_t Pots::get(uint8_t index) {
+uint16_t Pots::get_hires(uint8_t index) {
 	if (index >= config_.num_pots || index >= kMaxPots) return 0;
+	return apply_curve(index, read_value(index));
+}
+
+uint16_t Pots::get_dac_code(uint8_t index) {
+	if (index >= config_.num_pots || index >= kMaxPots) return 0;
+	uint16_t value = apply_curve(index, read_value(index));
+	uint16_t code = (value + (1 << (kFractionBits - 1))) >> kFractionBits;
+	return code > 4095 ? 4095 : code;
+}
+
+void Pots::update_scale() {
+	if (config_.output_resolution == 0) config_.output_resolution = 1;
+	if (config_.output_resolution > kMaxOutputResolution) {
+		config_.output_resolution = kMaxOutputResolution;
+	}
 
-	uint16_t raw = get_raw(index);
+	// Smallest multiplier that maps kMaxValue to output_max. The result is
+	// within 1 of value * output_max / kMaxValue and never exceeds output_max.
+	uint32_t output_max = (1u << config_.output_resolution) - 1;
+	scale_mult_ = ((output_max << 16) + kMaxValue - 1) / kMaxValue;
+}
 
-	// Map from 12-bit ADC (0-4095) to desired output resolution
-	static constexpr uint16_t kAdcMaxValue = 4095;	// 12-bit ADC
-	uint16_t output_max = (1 << config_.output_resolution) - 1;
+uint16_t Pots::scale(uint16_t value) const {
+	// Multiply and shift instead of dividing by the ADC range
+	return (value * scale_mult_) >> 16;
+}
 
-	return (raw * output_max) / kAdcMaxValue;
+uint16_t Pots::get(uint8_t index) {
+	if (index >= config_.num_pots || index >= kMaxPots) return 0;
+	return scale(apply_curve(index, read_value(index)));
+}
+
+void Pots::check_change(uint8_t index, uint16_t val) {
+	if (val > last_values_[index] + config_.change_threshold ||
+		val + config_.change_threshold < last_values_[index]) {
+		last_values_[index] = val;
+		if (on_change_) {
+			on_change_(index, val);
+		}
+	}
 }
 
 void Pots::scan() {
+	// The scheduler already reads in the background, polling it is cheap
+	if (config_.scan_mode == kScanIncremental && scheduler_ == nullptr) {
+		scan_incremental();
+		return;
+	}
+
+	// Background mode reads the snapshot, so this loop never touches the ADC
+
 	for (uint8_t i = 0; i < config_.num_pots && i < kMaxPots; ++i) {
-		uint16_t val = get(i);
-		if (val > last_values_[i] + config_.change_threshold ||
-			val + config_.change_threshold < last_values_[i]) {
-			last_values_[i] = val;
-			if (on_change_) {
-				on_change_(i, val);
-			}
-		}
+		check_change(i, get(i));
 	}
 }
 
-void Pots::set_on_change(std::function<void(uint8_t, uint16_t)> cb) {
+void Pots::set_on_change(brain::utils::Delegate<void(uint8_t, uint16_t)> cb) {
 	on_change_ = cb;
 }
 
@@ -0,0 +1,72 @@
+#include "brain-utils/cic-decimator.h"
+
+namespace brain::utils {
+
+bool CicDecimator::init(uint8_t decimation_log2) {
+	if (decimation_log2 < kMinDecimationLog2 || decimation_log2 > kMaxDecimationLog2) {
+		return false;
+	}
+
+	decimation_log2_ = decimation_log2;
+	reset();
+	return true;
+}
+
+void CicDecimator::reset() {
+	for (uint8_t i = 0; i < kOrder; i++) {
+		integrator_[i] = 0;
+		comb_delay_[i] = 0;
+	}
+	phase_ = 0;
+	value_ = 0;
+}
+
+/**
+ * Integrators run at the input rate, combs at the output rate. The CIC gain
+ * is R^3, so the comb output has 12 + 3 * log2(R) bits and is shifted to 16.
+ */
+size_t CicDecimator::process(const uint16_t* in, size_t n, uint16_t* out) {
+	const uint16_t decimation_mask = (1u << decimation_log2_) - 1;
+	const int8_t shift = kInputBits + kOrder * decimation_log2_ - kOutputBits;
+	size_t produced = 0;
+
+	for (size_t i = 0; i < n; i++) {
+		integrator_[0] += in[i];
+		integrator_[1] += integrator_[0];
+		integrator_[2] += integrator_[1];
+
+		phase_ = (phase_ + 1) & decimation_mask;
+		if (phase_ != 0) {
+			continue;
+		}
+
+		uint64_t stage = integrator_[2];
+		for (uint8_t c = 0; c < kOrder; c++) {
+			uint64_t delayed = comb_delay_[c];
+			comb_delay_[c] = stage;
+			stage -= delayed;
+		}
+
+		uint32_t result = shift >= 0 ? static_cast<uint32_t>(stage >> shift)
+									 : static_cast<uint32_t>(stage << -shift);
+		if (result > 0xFFFF) result = 0xFFFF;
+
+		value_ = static_cast<uint16_t>(result);
+		if (out != nullptr) {
+			out[produced] = value_;
+		}
+		produced++;
+	}
+
+	return produced;
+}
+
+uint16_t CicDecimator::value() const {
+	return value_;
+}
+
+uint16_t CicDecimator::get_decimation() const {
+	return static_cast<uint16_t>(1u << decimation_log2_);
+}
+
+}  // namespace brain::utils
@@ -0,0 +1,146 @@
+#include "brain-utils/envelope.h"
+
+#include <math.h>
+
+namespace brain::utils {
+
+void Envelope::init(uint32_t tick_rate_hz) {
+	tick_rate_hz_ = tick_rate_hz > 0 ? tick_rate_hz : 1;
+	stage_ = Stage::kIdle;
+	level_ = 0;
+
+	// Recompute coefficients for the new tick rate
+	set_attack_ms(attack_ms_);
+	set_decay_ms(decay_ms_);
+	set_release_ms(release_ms_);
+}
+
+void Envelope::set_shape(Shape shape) {
+	shape_ = shape;
+}
+
+Envelope::Shape Envelope::get_shape() const {
+	return shape_;
+}
+
+void Envelope::set_attack_ms(uint32_t ms) {
+	attack_ms_ = ms;
+	attack_coefficient_ = coefficient_for_ms(ms, kAttackOvershoot);
+}
+
+void Envelope::set_decay_ms(uint32_t ms) {
+	decay_ms_ = ms;
+	decay_coefficient_ = coefficient_for_ms(ms, kDecayOvershoot);
+}
+
+void Envelope::set_release_ms(uint32_t ms) {
+	release_ms_ = ms;
+	release_coefficient_ = coefficient_for_ms(ms, kDecayOvershoot);
+}
+
+void Envelope::set_sustain(uint16_t level) {
+	if (level > kMaxOutput) level = kMaxOutput;
+	sustain_level_ = static_cast<int32_t>(level) << kLevelFractionBits;
+}
+
+void Envelope::gate_on(bool retrigger) {
+	// Legato: keep running if the gate is already open
+	if (!retrigger && (stage_ == Stage::kAttack || stage_ == Stage::kDecay ||
+		stage_ == Stage::kSustain)) {
+		return;
+	}
+
+	// Attack starts from the current level to avoid clicks on retrigger
+	stage_ = Stage::kAttack;
+}
+
+void Envelope::gate_off() {
+	// In AR mode the release follows the attack regardless of the gate
+	if (shape_ == kAr) return;
+
+	if (stage_ != Stage::kIdle) {
+		stage_ = Stage::kRelease;
+	}
+}
+
+/**
+ * Each stage moves level_ a fixed fraction of the way towards a target that
+ * lies past the end of the segment: level += (target - level) * coefficient.
+ * The difference is pre-shifted so the Q15 multiply fits into 32 bits.
+ */
+uint16_t Envelope::tick() {
+	switch (stage_) {
+		case Stage::kAttack: {
+			int32_t target = kLevelMax + kAttackOvershoot;
+			level_ += (((target - level_) >> 8) * attack_coefficient_) >> 7;
+			if (level_ >= kLevelMax) {
+				level_ = kLevelMax;
+				stage_ = (shape_ == kAr) ? Stage::kRelease : Stage::kDecay;
+			}
+			break;
+		}
+
+		case Stage::kDecay: {
+			int32_t target = sustain_level_ - kDecayOvershoot;
+			level_ += (((target - level_) >> 8) * decay_coefficient_) >> 7;
+			if (level_ <= sustain_level_) {
+				level_ = sustain_level_;
+				stage_ = Stage::kSustain;
+			}
+			break;
+		}
+
+		case Stage::kSustain: {
+			// Follow sustain changes while the gate is held
+			level_ = sustain_level_;
+			break;
+		}
+
+		case Stage::kRelease: {
+			int32_t target = -kDecayOvershoot;
+			level_ += (((target - level_) >> 8) * release_coefficient_) >> 7;
+			if (level_ <= 0) {
+				level_ = 0;
+				stage_ = Stage::kIdle;
+			}
+			break;
+		}
+
+		case Stage::kIdle:
+		default:
+			break;
+	}
+
+	return value();
+}
+
+uint16_t Envelope::value() const {
+	return static_cast<uint16_t>(level_ >> kLevelFractionBits);
+}
+
+bool Envelope::is_active() const {
+	return stage_ != Stage::kIdle;
+}
+
+/**
+ * The coefficient is chosen so a full-scale segment reaches its end in the
+ * requested time: the distance to the overshoot target shrinks from
+ * (max + overshoot) to overshoot, i.e. ln((max + overshoot) / overshoot) time
+ * constants. Only called when parameters change.
+ */
+int32_t Envelope::coefficient_for_ms(uint32_t ms, int32_t overshoot) const {
+	float ticks = static_cast<float>(ms) * static_cast<float>(tick_rate_hz_) / 1000.0f;
+	if (ticks <= 1.0f) {
+		return kCoefficientOne;
+	}
+
+	float time_constants = logf(static_cast<float>(kLevelMax + overshoot) / overshoot);
+	float coefficient = 1.0f - expf(-time_constants / ticks);
+	int32_t q15 = static_cast<int32_t>(coefficient * kCoefficientOne + 0.5f);
+
+	if (q15 < 1) return 1;
+	if (q15 > kCoefficientOne) return kCoefficientOne;
+	return q15;
+}
+
+}  // namespace brain::utils
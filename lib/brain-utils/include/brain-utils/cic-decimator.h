@@ -0,0 +1,66 @@
+#ifndef BRAIN_CIC_DECIMATOR_H_
+#define BRAIN_CIC_DECIMATOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace brain::utils {
+
+/**
+ * @brief Third-order CIC decimator for oversampled 12-bit ADC data
+ *
+ * Averages R = 2^decimation_log2 input samples per output with a sinc^3
+ * response, trading sample rate for resolution. Uncorrelated ADC noise acts
+ * as dither, so every 4x of decimation adds about one effective bit.
+ *
+ * Outputs are normalized to 16 bits (input value * 16), independent of the
+ * decimation factor. Integrators wrap modulo 2^64, which is exact for the
+ * 12 + 3 * 10 = 42 bits needed at the maximum decimation.
+ */
+class CicDecimator {
+	public:
+		static constexpr uint8_t kOrder = 3;
+		static constexpr uint8_t kMinDecimationLog2 = 1;
+		static constexpr uint8_t kMaxDecimationLog2 = 10;  // R = 1024
+		static constexpr uint8_t kInputBits = 12;
+		static constexpr uint8_t kOutputBits = 16;
+
+		/**
+		 * @brief Set decimation factor and reset state
+		 * @param decimation_log2 R = 2^decimation_log2 (1-10)
+		 * @return false if decimation_log2 is out of range
+		 */
+		bool init(uint8_t decimation_log2);
+
+		/**
+		 * @brief Clear filter state and the latest output
+		 */
+		void reset();
+
+		/**
+		 * @brief Feed input samples, writing one output every R inputs
+		 * @param in 12-bit input samples
+		 * @param n Number of input samples
+		 * @param out Output buffer with room for n / R + 1 samples, may be nullptr
+		 * @return Number of outputs produced
+		 */
+		size_t process(const uint16_t* in, size_t n, uint16_t* out);
+
+		/**
+		 * @brief Get the latest 16-bit output
+		 */
+		uint16_t value() const;
+
+		uint16_t get_decimation() const;
+
+	private:
+		uint64_t integrator_[kOrder] = {0, 0, 0};
+		uint64_t comb_delay_[kOrder] = {0, 0, 0};
+		uint8_t decimation_log2_ = kMinDecimationLog2;
+		uint16_t phase_ = 0;
+		volatile uint16_t value_ = 0;
+};
+
+}  // namespace brain::utils
+
+#endif
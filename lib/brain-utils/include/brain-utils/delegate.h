@@ -0,0 +1,117 @@
+#ifndef BRAIN_DELEGATE_H_
+#define BRAIN_DELEGATE_H_
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace brain::utils {
+
+static constexpr size_t kDelegateCapacity = 4 * sizeof(void*);
+
+template <typename Signature, size_t Capacity = kDelegateCapacity>
+class Delegate;
+
+/**
+ * @brief Non-allocating callback holder, a fixed-size replacement for std::function
+ *
+ * The callable is copied into inline storage of Capacity bytes, so assigning
+ * a capturing lambda never touches the heap. Callables must be trivially
+ * copyable and destructible (lambdas capturing pointers, references and plain
+ * values are), and must fit the storage; both are checked at compile time.
+ *
+ * A C-style function with a context pointer can be bound directly, which is
+ * what the lambda form compiles down to anyway. Invoking is a single indirect
+ * call through a pointer to a thunk that knows the stored type.
+ *
+ * Usage:
+ *   Delegate<void(uint8_t)> cb = [this](uint8_t v) { handle(v); };
+ *   Delegate<void(uint8_t)> cb2(&on_value, &state);  // void on_value(void*, uint8_t)
+ *   if (cb) cb(42);
+ */
+template <typename R, typename... Args, size_t Capacity>
+class Delegate<R(Args...), Capacity> {
+	public:
+		using Function = R (*)(void* context, Args... args);
+
+		static_assert(Capacity >= 2 * sizeof(void*), "Delegate: capacity too small");
+
+		Delegate() = default;
+		Delegate(std::nullptr_t) {}
+
+		/**
+		 * @brief Bind a plain function and the context pointer passed to it
+		 */
+		Delegate(Function function, void* context) {
+			if (function == nullptr) return;
+			new (storage_) Bound{function, context};
+			invoke_ = &invoke_bound;
+		}
+
+		/**
+		 * @brief Store a lambda, functor or function pointer
+		 */
+		template <typename F, typename Fn = std::decay_t<F>,
+			typename = std::enable_if_t<!std::is_same_v<Fn, Delegate> &&
+				std::is_invocable_r_v<R, Fn&, Args...>>>
+		Delegate(F&& callable) {
+			static_assert(sizeof(Fn) <= Capacity, "Delegate: callable too large, capture less");
+			static_assert(alignof(Fn) <= alignof(std::max_align_t),
+				"Delegate: callable is overaligned");
+			static_assert(std::is_trivially_copyable_v<Fn> && std::is_trivially_destructible_v<Fn>,
+				"Delegate: captures must be trivially copyable (pointers, references, values)");
+
+			if constexpr (std::is_pointer_v<Fn>) {
+				if (callable == nullptr) return;
+			}
+			new (storage_) Fn(std::forward<F>(callable));
+			invoke_ = &invoke_callable<Fn>;
+		}
+
+		Delegate& operator=(std::nullptr_t) {
+			invoke_ = nullptr;
+			return *this;
+		}
+
+		explicit operator bool() const {
+			return invoke_ != nullptr;
+		}
+
+		/**
+		 * @brief Call the stored callable, must not be empty
+		 */
+		R operator()(Args... args) const {
+			return invoke_(storage_, std::forward<Args>(args)...);
+		}
+
+	private:
+		using Invoker = R (*)(void* storage, Args... args);
+
+		struct Bound {
+			Function function;
+			void* context;
+		};
+
+		static R invoke_bound(void* storage, Args... args) {
+			Bound* bound = std::launder(reinterpret_cast<Bound*>(storage));
+			return bound->function(bound->context, std::forward<Args>(args)...);
+		}
+
+		template <typename Fn>
+		static R invoke_callable(void* storage, Args... args) {
+			Fn& fn = *std::launder(reinterpret_cast<Fn*>(storage));
+			if constexpr (std::is_void_v<R>) {
+				fn(std::forward<Args>(args)...);
+			} else {
+				return fn(std::forward<Args>(args)...);
+			}
+		}
+
+		alignas(std::max_align_t) mutable unsigned char storage_[Capacity] = {};
+		Invoker invoke_ = nullptr;
+};
+
+}  // namespace brain::utils
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef BRAIN_ENVELOPE_H_
+#define BRAIN_ENVELOPE_H_
+
+#include <stdint.h>
+
+namespace brain::utils {
+
+/**
+ * @brief Fixed-point ADSR/AR envelope generator
+ *
+ * Segments are exponential, computed as a one-pole approach towards an
+ * overshoot target (like an analog RC envelope). Every call to tick() costs
+ * the same handful of integer operations regardless of stage, so the envelope
+ * can be run from a fixed-rate control tick next to MIDI processing.
+ *
+ * Output is a 12-bit value (0-4095) that can be written straight to the DAC.
+ */
+class Envelope {
+	public:
+		enum Shape {
+			kAdsr = 0,	// Attack, decay, sustain while gate is held, release on gate off
+			kAr = 1		// Attack then release, gate length is ignored
+		};
+
+		static constexpr uint16_t kMaxOutput = 4095;
+
+		/**
+		 * @brief Set the control tick rate and reset to idle
+		 * @param tick_rate_hz Rate at which tick() will be called
+		 */
+		void init(uint32_t tick_rate_hz);
+
+		void set_shape(Shape shape);
+		Shape get_shape() const;
+
+		/**
+		 * Segment times in milliseconds. Coefficients are computed here so
+		 * tick() never has to touch floating point.
+		 */
+		void set_attack_ms(uint32_t ms);
+		void set_decay_ms(uint32_t ms);
+		void set_release_ms(uint32_t ms);
+
+		/**
+		 * @brief Set sustain level
+		 * @param level Sustain level (0-4095)
+		 */
+		void set_sustain(uint16_t level);
+
+		/**
+		 * @brief Open the gate
+		 * @param retrigger If true, restart the attack from the current level.
+		 * If false and the envelope is already running (legato), keep going.
+		 */
+		void gate_on(bool retrigger = true);
+
+		/**
+		 * @brief Close the gate and start the release stage
+		 */
+		void gate_off();
+
+		/**
+		 * @brief Advance the envelope by one control tick
+		 * @return Current output value (0-4095)
+		 */
+		uint16_t tick();
+
+		uint16_t value() const;
+		bool is_active() const;
+
+	private:
+		enum class Stage : uint8_t { kIdle, kAttack, kDecay, kSustain, kRelease };
+
+		// Level is 12-bit output with 10 fractional bits
+		static constexpr uint8_t kLevelFractionBits = 10;
+		static constexpr int32_t kLevelMax = static_cast<int32_t>(kMaxOutput) << kLevelFractionBits;
+
+		// Overshoot past the end of a segment so the exponential actually reaches it
+		static constexpr int32_t kAttackOvershoot = kLevelMax / 3;
+		static constexpr int32_t kDecayOvershoot = kLevelMax / 100;
+
+		// Coefficients are Q15
+		static constexpr int32_t kCoefficientOne = 1 << 15;
+
+		int32_t coefficient_for_ms(uint32_t ms, int32_t overshoot) const;
+
+		uint32_t tick_rate_hz_ = 1000;
+		Shape shape_ = kAdsr;
+		Stage stage_ = Stage::kIdle;
+		int32_t level_ = 0;
+		int32_t sustain_level_ = kLevelMax;
+
+		uint32_t attack_ms_ = 5;
+		uint32_t decay_ms_ = 200;
+		uint32_t release_ms_ = 300;
+
+		int32_t attack_coefficient_ = kCoefficientOne;
+		int32_t decay_coefficient_ = kCoefficientOne;
+		int32_t release_coefficient_ = kCoefficientOne;
+};
+
+}  // namespace brain::utils
+
+#endif
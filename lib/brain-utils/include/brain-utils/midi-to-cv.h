@@ -1,14 +1,19 @@
 #ifndef BRAIN_MIDI_TO_CV_H_
 #define BRAIN_MIDI_TO_CV_H_
 
+#include <hardware/uart.h>
 #include <pico/stdlib.h>
 #include <stdint.h>
 #include <stdio.h>
 
+#include "brain-common/brain-common.h"
 #include "brain-io/audio-cv-out.h"
 #include "brain-io/pulse.h"
 #include "brain-io/midi-parser.h"
+#include "brain-utils/envelope.h"
 #include "brain-utils/helpers.h"
+#include "brain-utils/note-stack.h"
+#include "brain-utils/tuning.h"
 
 namespace brain::utils {
 
@@ -18,16 +23,50 @@ class MidiToCV {
 			kDefault = 0, 	// Pitch on selected channel, velocity on the other
 			kModWheel = 1, 	// Pitch on selected channel, modwheel on the other
 			kUnison = 2,	// Pitch on both channel
-			kDuo = 3		// Duophonic mode with first note on selected channel
+			kDuo = 3,		// Two voices, first voice on selected channel, see DuoPolicy
+			kEnvelope = 4	// Pitch on selected channel, envelope on the other
 		};
 
+		// Which held note drives the pitch CV
+		enum NotePriority {
+			kPriorityLast = 0,	// Most recent note, falls back to the previous one on release
+			kPriorityLow = 1,	// Lowest held note
+			kPriorityHigh = 2,	// Highest held note
+			kPriorityFirst = 3	// Oldest held note, new notes don't steal
+		};
+
+		// How notes are assigned to the two voices in kDuo mode
+		enum DuoPolicy {
+			kDuoRoundRobin = 0,	// Alternate voices, steal the older one when both sound
+			kDuoSplit = 1,		// Lowest held note on the first voice, highest on the second
+			kDuoReuse = 2		// Prefer the free voice that last played the same note
+		};
+
+		static constexpr uint8_t kMaxPitchBendRange = 24;	// Semitones
+
 		// Call this in main loop
 		void update();
 
 		void set_mode(Mode mode);
 		Mode get_mode() const;
 
-		bool init(brain::io::AudioCvOutChannel cv_channel, uint8_t midi_channel);
+		void set_note_priority(NotePriority priority);
+		NotePriority get_note_priority() const;
+
+		void set_duo_policy(DuoPolicy policy);
+		DuoPolicy get_duo_policy() const;
+
+		/**
+		 * @brief Set up the DAC, the gate and MIDI input
+		 *
+		 * @param cv_channel DAC channel for pitch CV
+		 * @param midi_channel MIDI channel to listen on (1-16)
+		 * @param uart UART the MIDI input arrives on
+		 * @param rx_gpio GPIO pin for UART RX
+		 * @return false if MIDI input could not be initialized
+		 */
+		bool init(brain::io::AudioCvOutChannel cv_channel, uint8_t midi_channel,
+			uart_inst_t* uart = uart1, uint8_t rx_gpio = GPIO_BRAIN_MIDI_RX);
 		void set_midi_channel(uint8_t midi_channel);
 		void set_pitch_channel(brain::io::AudioCvOutChannel cv_channel);
 
@@ -47,6 +86,27 @@ class MidiToCV {
 
 		void set_max_cc_voltage(uint8_t max_voltage);
 
+		// Pitch CV calibration: scale trims volts per octave (1.0 = 1V/oct),
+		// offset shifts every note in volts. Rebuilds the note to DAC table.
+		void set_pitch_calibration(float scale, float offset_volts = 0.0f);
+
+		// Use a microtonal tuning for note to CV conversion, nullptr for 12-TET.
+		// The tuning must outlive this object; call again after changing it to
+		// rebuild the note table. Notes the tuning leaves unmapped are ignored.
+		void set_tuning(const Tuning* tuning);
+
+		// Pitch bend range in semitones (0-kMaxPitchBendRange), default 2.
+		// Also set by the sender through RPN 0 (pitch bend sensitivity).
+		void set_pitch_bend_range(uint8_t semitones, uint8_t cents = 0);
+		uint8_t get_pitch_bend_range() const;
+
+		// Envelope settings, used in kEnvelope mode
+		Envelope& envelope();
+
+		// With legato on, overlapping notes don't retrigger the envelope
+		void set_legato(bool legato);
+		bool get_legato() const;
+
 		void enable_cv();
 		void disable_cv();
 
@@ -54,20 +114,26 @@ class MidiToCV {
 		virtual void note_on(uint8_t note, uint8_t velocity, uint8_t channel);
 		virtual void note_off(uint8_t note, uint8_t velocity, uint8_t channel);
 		virtual void control_change(uint8_t cc, uint8_t value, uint8_t channel);
+		virtual void pitch_bend(int16_t value, uint8_t channel);
 
 	private:
-		static constexpr uint8_t kNoteStackSize = 25;
 		static constexpr uint8_t kZeroCVMidiNote = 24; // 0V CV is mapped to C1
+		static constexpr uint8_t kNumNotes = 128;
+		static constexpr uint8_t kBendSmoothShift = 2;	// One-pole step per control tick
+		static constexpr uint32_t kControlTickUs =
+			brain::constants::kMicrosPerSecond / brain::constants::kDefaultControlRate;
+		static constexpr uint8_t kMaxCatchUpTicks = 8;
 
 		struct NoteVelocity {
 			uint8_t note;
 			uint8_t velocity;
 		};
 
-		static MidiToCV* instance_;
 		brain::io::MidiParser midi_parser_;
 
 		Mode mode_;
+		NotePriority priority_ = kPriorityLast;
+		DuoPolicy duo_policy_ = kDuoRoundRobin;
 
 		bool cv_enabled_;
 		brain::io::AudioCvOutChannel cv_channel_;
@@ -78,30 +144,59 @@ class MidiToCV {
 		brain::io::Pulse gate_;
 		bool gate_on_;
 
-		NoteVelocity note_stack_[kNoteStackSize];
-		uint8_t current_stack_size_;
+		NoteStack note_stack_;
 		NoteVelocity last_note_;
+		uint8_t priority_note() const;
+
+		// Duo voices, voice 0 on cv_channel_ and voice 1 on cv_other_channel_
+		static constexpr uint8_t kNumVoices = 2;
+		uint8_t voice_note_[kNumVoices];	// Held note per voice, NoteStack::kNoNote when free
+		uint8_t voice_pitch_[kNumVoices];	// Last note per voice, kept on the CV after release
+		uint8_t last_voice_;	// Most recently assigned voice
+		void reset_voices();
+		void allocate_voice(uint8_t note);
+		void release_voice(uint8_t note);
+		void set_duo_cv();
 
 		uint8_t modwheel_value_;
 
-		static void note_on_callback(uint8_t note, uint8_t velocity, uint8_t channel);
-		static void note_off_callback(uint8_t note, uint8_t velocity, uint8_t channel);
-		static void control_change_callback(uint8_t cc, uint8_t value, uint8_t channel);
-
-		NoteOnCallback note_on_callback_ = nullptr;
-		NoteOffCallback note_off_callback_ = nullptr;
-		ControlChangeCallback control_change_callback_ = nullptr;
-
-		void push_note(uint8_t note, uint8_t velocity);
-		void pop_note(uint8_t note);
-		int find_note(uint8_t note);
+		NoteOnCallback note_on_callback_;
+		NoteOffCallback note_off_callback_;
+		ControlChangeCallback control_change_callback_;
 
 		uint8_t max_cc_voltage_;
-		void set_cc_cv(float cc_voltage);
+		void set_cc_dac(uint16_t dac_value);
+
+		// Lookup tables, so note and CC events need no float math
+		uint16_t pitch_table_[kNumNotes];	// Note to DAC code Q4, with calibration
+		uint16_t cc_table_[kNumNotes];	// Velocity/CC value to DAC code, up to max_cc_voltage_
+		float pitch_scale_;
+		float pitch_offset_;
+		const Tuning* tuning_;
+		uint32_t note_mapped_[4];	// Notes that play under the current tuning
+		int32_t semitone_q8_;	// DAC codes per semitone, Q8, for pitch bend
+		void build_pitch_table();
+
+		Envelope envelope_;
+		bool legato_;
+		uint16_t envelope_scale_;  // Q12 scale from envelope output to max_cc_voltage_
+		uint32_t next_control_tick_us_;
+		void run_control_ticks();
 
 		void set_cv();
 
-		float midi_value_to_voltage(uint8_t value);
+		// Pitch bend, in DAC codes Q8 so it adds straight onto the note pitch
+		uint8_t bend_range_semitones_;
+		uint8_t bend_range_cents_;
+		int32_t bend_scale_;	// Full-scale bend in DAC codes Q8
+		int16_t bend_value_;	// Last received bend, -8192 to 8191
+		int32_t bend_target_;
+		int32_t bend_;	// Smoothed at the control tick
+		uint8_t rpn_msb_;
+		uint8_t rpn_lsb_;
+		uint16_t pitch_to_dac(uint8_t note) const;
+		void update_pitch_cv();
+
 	};
 
 }
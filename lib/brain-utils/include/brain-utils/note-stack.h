@@ -0,0 +1,79 @@
+#ifndef BRAIN_NOTE_STACK_H_
+#define BRAIN_NOTE_STACK_H_
+
+#include <stdint.h>
+
+namespace brain::utils {
+
+/**
+ * @brief Set of held MIDI notes with press order, for monophonic note priority
+ *
+ * Membership is a 128-bit bitmap, press order an intrusive doubly-linked list
+ * threaded through per-note prev/next arrays. Every note 0-127 has its own
+ * slot, so all notes can be held at once and nothing is ever shifted.
+ *
+ * push, remove, contains, last and first are O(1); lowest and highest scan
+ * the four bitmap words with count-leading/trailing-zeros.
+ */
+class NoteStack {
+	public:
+		static constexpr uint8_t kNumNotes = 128;
+		static constexpr uint8_t kNoNote = 0xFF;
+
+		NoteStack();
+
+		/**
+		 * @brief Release all notes
+		 */
+		void reset();
+
+		/**
+		 * @brief Add a note as the most recent one
+		 *
+		 * A note that is already held moves to the top with the new velocity.
+		 * @return false if note is out of range
+		 */
+		bool push(uint8_t note, uint8_t velocity);
+
+		/**
+		 * @brief Remove a note
+		 * @return false if the note wasn't held
+		 */
+		bool remove(uint8_t note);
+
+		bool contains(uint8_t note) const;
+		uint8_t size() const;
+		bool empty() const;
+
+		/**
+		 * @brief Velocity of a held note, 0 if not held
+		 */
+		uint8_t velocity(uint8_t note) const;
+
+		// Queries return kNoNote when the stack is empty
+		uint8_t last() const;  // Most recently pushed
+		uint8_t first() const;  // Oldest held
+		uint8_t lowest() const;
+		uint8_t highest() const;
+
+		/**
+		 * @brief Press order neighbours, kNoNote at the ends or if note isn't held
+		 */
+		uint8_t older(uint8_t note) const;
+		uint8_t newer(uint8_t note) const;
+
+	private:
+		void unlink(uint8_t note);
+
+		uint32_t bits_[4];
+		uint8_t prev_[kNumNotes];  // Older neighbour
+		uint8_t next_[kNumNotes];  // Newer neighbour
+		uint8_t velocity_[kNumNotes];
+		uint8_t head_;  // Oldest
+		uint8_t tail_;  // Newest
+		uint8_t size_;
+};
+
+}  // namespace brain::utils
+
+#endif
@@ -0,0 +1,172 @@
+#ifndef BRAIN_QUANTIZER_H_
+#define BRAIN_QUANTIZER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "brain-io/audio-cv-in.h"
+#include "brain-io/audio-cv-out.h"
+#include "brain-io/pulse.h"
+
+namespace brain::utils {
+
+/**
+ * @brief Scale quantizer from a CV input to a CV output at 1V/octave
+ *
+ * The input is snapped to the nearest pitch allowed by a 12-bit scale mask
+ * (bit 0 is the root, bit 11 the major seventh) and written to the DAC. All
+ * float math happens when the scale changes: every allowed pitch between -5V
+ * and +5V gets a threshold in millivolts and a ready DAC code, so quantizing
+ * is an integer binary search over at most kMaxPitches entries.
+ *
+ * Hysteresis widens the current pitch's window on both sides, so an input
+ * sitting on a threshold doesn't chatter. Every pitch change can fire a
+ * trigger on the Pulse output.
+ *
+ * Usually driven from AudioCvIn streaming: each block is averaged and
+ * quantized in the DMA interrupt, so input to output latency is one block
+ * plus one DAC frame, e.g. 0.5ms blocks at a 128kHz stream rate.
+ */
+class Quantizer {
+	public:
+		// Common scale masks with the root on bit 0
+		static constexpr uint16_t kChromatic = 0x0FFF;
+		static constexpr uint16_t kMajor = 0x0AB5;
+		static constexpr uint16_t kMinor = 0x05AD;
+		static constexpr uint16_t kMajorPentatonic = 0x0295;
+		static constexpr uint16_t kMinorPentatonic = 0x04A9;
+
+		// Input range in semitones from 0V, +/-5V at 1V/octave
+		static constexpr int8_t kMinSemitone = -60;
+		static constexpr int8_t kMaxSemitone = 60;
+		static constexpr uint8_t kMaxPitches = kMaxSemitone - kMinSemitone + 1;
+
+		static constexpr int32_t kDefaultHysteresisMv = 10;	// About 1/8 semitone
+		static constexpr uint32_t kDefaultTriggerWidthUs = 1000;
+
+		/**
+		 * @brief Attach to the input, the output and optionally the trigger output
+		 *
+		 * Starts chromatic with the root on C. Components must be initialized
+		 * and outlive this object.
+		 *
+		 * @param input CV input to quantize
+		 * @param input_channel kChannelA or kChannelB
+		 * @param output DAC for the quantized CV
+		 * @param output_channel DAC channel for the quantized CV
+		 * @param pulse Trigger output on pitch changes, nullptr for none
+		 * @return false if input or output is null or input_channel is invalid
+		 */
+		bool init(brain::io::AudioCvIn* input, int input_channel, brain::io::AudioCvOut* output,
+			brain::io::AudioCvOutChannel output_channel, brain::io::Pulse* pulse = nullptr);
+
+		/**
+		 * @brief Start streaming the input with process_block() as the block callback
+		 *
+		 * The stream is owned by AudioCvIn, so call process_block() from an own
+		 * callback instead when the other channel is needed too.
+		 *
+		 * @param sample_rate_hz Per-channel stream rate, see AudioCvIn::start_stream()
+		 * @return false if streaming could not start
+		 */
+		bool start(uint32_t sample_rate_hz);
+
+		/**
+		 * @brief Stop the stream started by start()
+		 */
+		void stop();
+
+		/**
+		 * @brief Select the allowed pitches
+		 *
+		 * @param mask Bit n allows the pitch n semitones above the root (bits 0-11)
+		 * @param root Semitone of the root above C (0-11)
+		 * @return false if no pitch is allowed or root is out of range
+		 */
+		bool set_scale(uint16_t mask, uint8_t root = 0);
+		uint16_t get_scale() const;
+		uint8_t get_root() const;
+
+		/**
+		 * @brief Extra distance past a threshold before the pitch changes
+		 *
+		 * @param millivolts Hysteresis, 0 to disable
+		 */
+		void set_hysteresis_mv(int32_t millivolts);
+
+		/**
+		 * @brief Shift the output against the input
+		 *
+		 * The DAC only covers 0-10V, so 0V in gives 0V out by default and
+		 * negative inputs clamp to 0V. Shift up to use the whole input range.
+		 *
+		 * @param octaves Output offset in octaves (-5 to 10)
+		 */
+		void set_output_octave(int8_t octaves);
+
+		/**
+		 * @brief Width of the trigger fired on pitch changes
+		 *
+		 * @param width_us Pulse width in microseconds, 0 for no triggers
+		 */
+		void set_trigger_width_us(uint32_t width_us);
+
+		/**
+		 * @brief Quantize one streamed block, the AudioCvIn process callback
+		 *
+		 * Averages the input channel's samples and passes them to process_mv().
+		 * Interrupt safe.
+		 */
+		void process_block(const uint16_t* a, const uint16_t* b, size_t n);
+
+		/**
+		 * @brief Quantize one input value and update the output on a change
+		 *
+		 * For polled use with AudioCvIn::get_millivolts(). Interrupt safe.
+		 *
+		 * @param millivolts Input level in millivolts
+		 */
+		void process_mv(int32_t millivolts);
+
+		/**
+		 * @brief Current output pitch in semitones from 0V at the input
+		 */
+		int8_t get_semitone() const;
+
+	private:
+		struct Table {
+			int16_t threshold_mv[kMaxPitches];	// Lower edge of each pitch, entry 0 unused
+			uint16_t dac_code[kMaxPitches];
+			int8_t semitone[kMaxPitches];
+			uint8_t size;
+		};
+
+		void build_table();
+		uint8_t search(int32_t millivolts) const;
+
+		brain::io::AudioCvIn* input_ = nullptr;
+		int input_channel_ = brain::io::AudioCvInChannel::kChannelA;
+		brain::io::AudioCvOut* output_ = nullptr;
+		brain::io::AudioCvOutChannel output_channel_ = brain::io::AudioCvOutChannel::kChannelA;
+		brain::io::Pulse* pulse_ = nullptr;
+
+		uint16_t mask_ = kChromatic;
+		uint8_t root_ = 0;
+		int8_t output_octave_ = 0;
+		int32_t hysteresis_mv_ = kDefaultHysteresisMv;
+		uint32_t trigger_width_us_ = kDefaultTriggerWidthUs;
+
+		// Shared with the interrupt, replaced with interrupts disabled
+		Table table_;
+		volatile uint8_t index_ = 0;
+		volatile bool index_valid_ = false;	// index_ refers to the current table
+
+		// Last output
+		bool has_output_ = false;
+		int8_t semitone_ = 0;
+		uint16_t dac_code_ = 0;
+};
+
+}  // namespace brain::utils
+
+#endif
@@ -0,0 +1,101 @@
+#ifndef BRAIN_SAMPLE_AND_HOLD_H_
+#define BRAIN_SAMPLE_AND_HOLD_H_
+
+#include <stdint.h>
+
+#include "brain-io/audio-cv-in.h"
+#include "brain-io/audio-cv-out.h"
+#include "brain-io/pulse.h"
+
+namespace brain::utils {
+
+/**
+ * @brief Sample and hold / track and hold from a CV input to a CV output
+ *
+ * Clocked by the Pulse input. The whole sample happens in the GPIO interrupt:
+ * AudioCvIn::sample_raw() takes the freshest input value, it's converted with
+ * integer math and written straight to the DAC, so the output follows the
+ * edge within tens of microseconds regardless of what the main loop is doing.
+ *
+ * - kSampleAndHold: each rising edge samples the input and holds it
+ * - kTrackAndHold: the output follows the input while the pulse is high and
+ *   holds the last value on the falling edge. Following happens in update().
+ *
+ * The DAC covers 0-10V and the input -5V to +5V; the output offset decides
+ * which part of the input range comes through, negative results clamp to 0V.
+ */
+class SampleAndHold {
+	public:
+		enum Mode {
+			kSampleAndHold = 0,
+			kTrackAndHold = 1
+		};
+
+		/**
+		 * @brief Attach to the input, the output and the clock
+		 *
+		 * Registers an interrupt edge callback and enables edge interrupts on
+		 * the Pulse. Components must be initialized and outlive this object.
+		 *
+		 * @param input CV input to sample
+		 * @param input_channel kChannelA or kChannelB
+		 * @param output DAC for the held value
+		 * @param output_channel DAC channel for the held value
+		 * @param pulse Clock input
+		 * @return false if a component is null or input_channel is invalid
+		 */
+		bool init(brain::io::AudioCvIn* input, int input_channel, brain::io::AudioCvOut* output,
+			brain::io::AudioCvOutChannel output_channel, brain::io::Pulse* pulse);
+
+		void set_mode(Mode mode);
+		Mode get_mode() const;
+
+		/**
+		 * @brief Voltage added to the input before it goes to the DAC
+		 *
+		 * @param millivolts -10000 to 10000; 0 passes 0-5V through, 5000 maps -5V..+5V to 0-10V
+		 */
+		void set_output_offset_mv(int32_t millivolts);
+
+		/**
+		 * @brief Follow the input in track mode, call regularly in the main loop
+		 *
+		 * Does nothing in kSampleAndHold mode or while holding.
+		 */
+		void update();
+
+		/**
+		 * @brief Last sampled input level in millivolts
+		 */
+		int32_t get_held_mv() const;
+
+		/**
+		 * @brief time_us_32() of the edge that took the last sample
+		 */
+		uint32_t get_sample_time_us() const;
+
+	private:
+		void handle_edge(bool rising, uint32_t time_us);
+		void sample();
+		uint16_t to_dac_code(int32_t millivolts) const;
+
+		brain::io::AudioCvIn* input_ = nullptr;
+		int input_channel_ = brain::io::AudioCvInChannel::kChannelA;
+		brain::io::AudioCvOut* output_ = nullptr;
+		brain::io::AudioCvOutChannel output_channel_ = brain::io::AudioCvOutChannel::kChannelA;
+		brain::io::Pulse* pulse_ = nullptr;
+
+		Mode mode_ = kSampleAndHold;
+		int32_t offset_mv_ = 0;
+
+		// Shared with the GPIO interrupt
+		volatile bool tracking_ = false;
+		volatile int32_t held_mv_ = 0;
+		volatile uint32_t sample_time_us_ = 0;
+		volatile uint16_t held_code_ = 0;
+		volatile uint32_t sample_count_ = 0;	// Edge samples, tells update() it was overtaken
+};
+
+}  // namespace brain::utils
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef BRAIN_SCHMITT_TRIGGER_H_
+#define BRAIN_SCHMITT_TRIGGER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace brain::utils {
+
+/**
+ * @brief Comparator with hysteresis for sample blocks
+ *
+ * Goes high when the input reaches the high threshold and low when it drops
+ * to the low threshold, so noise between the two doesn't cause chatter.
+ * Thresholds are in the same units as the samples (e.g. raw ADC values).
+ */
+class SchmittTrigger {
+	public:
+		struct Edge {
+			uint16_t index;	 // Sample index within the processed block
+			bool rising;
+		};
+
+		/**
+		 * @brief Set switching thresholds
+		 * @param low Output goes low at or below this value
+		 * @param high Output goes high at or above this value
+		 * @return false if low is not below high
+		 */
+		bool set_thresholds(uint16_t low, uint16_t high);
+
+		/**
+		 * @brief Set the output state without reporting an edge
+		 */
+		void reset(bool state = false);
+
+		/**
+		 * @brief Run a block of samples through the comparator
+		 * @param in Input samples
+		 * @param n Number of samples
+		 * @param edges Output for detected edges, in sample order
+		 * @param max_edges Capacity of edges; further edges update state but are dropped
+		 * @return Number of edges written
+		 */
+		size_t process(const uint16_t* in, size_t n, Edge* edges, size_t max_edges);
+
+		bool state() const;
+
+	private:
+		uint16_t low_ = 0;
+		uint16_t high_ = 0xFFFF;
+		bool state_ = false;
+};
+
+}  // namespace brain::utils
+
+#endif
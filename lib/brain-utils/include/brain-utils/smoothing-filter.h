@@ -0,0 +1,60 @@
+#ifndef BRAIN_SMOOTHING_FILTER_H_
+#define BRAIN_SMOOTHING_FILTER_H_
+
+#include <stdint.h>
+
+namespace brain::utils {
+
+/**
+ * @brief Adaptive one-pole smoother with hysteresis for 12-bit control inputs
+ *
+ * A fixed-point EMA whose coefficient grows with the distance between the
+ * input and the filter state: slow and quiet while a control rests, fast
+ * while it moves. The output trails the state by up to the deadband
+ * (backlash), so remaining noise doesn't make it flicker while continuous
+ * movement still produces continuous output.
+ *
+ * The output carries kFractionBits extra bits (12-bit input * 16). Averaging
+ * many single samples, with the ADC noise acting as dither, fills them with
+ * real resolution; the state keeps kStateBits so slow drifts aren't lost.
+ */
+class SmoothingFilter {
+	public:
+		static constexpr uint8_t kFractionBits = 4;
+		static constexpr uint8_t kStateBits = 8;
+		static constexpr uint16_t kMaxValue = 4095 << kFractionBits;
+		static constexpr uint16_t kAlphaOne = 256;	// Coefficient 1.0 in Q8
+
+		/**
+		 * @brief Set filter response
+		 * @param min_alpha Coefficient at rest in Q8 (1-256, lower is smoother)
+		 * @param sensitivity_shift Error (in output units) >> shift is added to
+		 *                          the coefficient, lower reacts faster to movement
+		 * @param deadband Hysteresis in output units (input LSB * 16)
+		 */
+		void set_params(uint16_t min_alpha, uint8_t sensitivity_shift, uint16_t deadband);
+
+		/**
+		 * @brief Jump state and output to a 12-bit value
+		 */
+		void reset(uint16_t value);
+
+		/**
+		 * @brief Feed one 12-bit sample
+		 * @return Output with kFractionBits extra bits
+		 */
+		uint16_t process(uint16_t sample);
+
+		uint16_t value() const;
+
+	private:
+		int32_t state_ = 0;	 // 12-bit value with kStateBits fraction bits
+		uint16_t output_ = 0;
+		uint16_t min_alpha_ = 8;  // ~32 samples time constant at rest
+		uint8_t sensitivity_shift_ = 2;
+		uint16_t deadband_ = 2 << kFractionBits;
+};
+
+}  // namespace brain::utils
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef BRAIN_TUNING_H_
+#define BRAIN_TUNING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace brain::utils {
+
+/**
+ * @brief Microtonal tuning as a fixed 128-entry note to pitch table
+ *
+ * Pitches are absolute, in cents on the MIDI note scale: 12-TET note n is
+ * n * 100 cents, so an unchanged note 60 is 6000. Scala scale (.scl) and
+ * keyboard mapping (.kbm) files are parsed from text buffers, e.g. a file
+ * embedded at build time or received over SysEx, and the table is rebuilt
+ * once per load. Consumers such as MidiToCV convert the table to their own
+ * lookup tables, so playing a retuned note costs nothing extra.
+ *
+ * Without a keyboard map, notes map linearly with note 60 on scale degree 0
+ * at middle C (261.626 Hz), so note 60 keeps its 12-TET pitch.
+ */
+class Tuning {
+	public:
+		static constexpr uint8_t kNumNotes = 128;
+		static constexpr uint8_t kMaxScaleSize = 128;	// Degrees in a .scl file
+		static constexpr uint8_t kMaxMapSize = 128;	// Entries in a .kbm file
+
+		Tuning();
+
+		/**
+		 * @brief Back to 12-tone equal temperament with the default keyboard map
+		 */
+		void set_equal_temperament();
+
+		/**
+		 * @brief Parse a Scala scale file and rebuild the table
+		 * @param text File contents, need not be null terminated
+		 * @param length Length of text in bytes
+		 * @return false on a format error, the previous tuning is kept then
+		 */
+		bool load_scl(const char* text, size_t length);
+
+		/**
+		 * @brief Parse a Scala keyboard mapping file and rebuild the table
+		 * @param text File contents, need not be null terminated
+		 * @param length Length of text in bytes
+		 * @return false on a format error, the previous tuning is kept then
+		 */
+		bool load_kbm(const char* text, size_t length);
+
+		/**
+		 * @brief Drop the keyboard mapping and use the default linear one
+		 */
+		void reset_keyboard_map();
+
+		/**
+		 * @brief Set a single table entry, e.g. from a host-computed table
+		 * @param note MIDI note (0-127)
+		 * @param cents Absolute pitch in cents, note * 100 in 12-TET
+		 * @return false if note is out of range
+		 */
+		bool set_note_cents(uint8_t note, float cents);
+
+		/**
+		 * @brief Absolute pitch of a note in cents, note * 100 in 12-TET
+		 */
+		float get_note_cents(uint8_t note) const;
+
+		/**
+		 * @brief Whether a note plays, false for keys the mapping leaves out
+		 */
+		bool is_mapped(uint8_t note) const;
+
+		uint8_t get_scale_size() const;
+
+	private:
+		struct KeyboardMap {
+			int8_t map[kMaxMapSize];	// Scale degree per key in the pattern, -1 unmapped
+			uint8_t size;	// 0 maps linearly
+			uint8_t first_note;
+			uint8_t last_note;
+			uint8_t middle_note;	// Key of scale degree 0
+			uint8_t reference_note;
+			float reference_hz;
+			uint8_t octave_degree;	// Degrees per repeat of the map, 0 for the scale size
+		};
+
+		static void default_map(KeyboardMap& map);
+		static bool note_degree(const KeyboardMap& map, uint8_t scale_size, uint8_t note,
+			int32_t& degree);
+		bool build_table(const float* scale, uint8_t scale_size, const KeyboardMap& map);
+
+		float scale_[kMaxScaleSize];	// Degrees 1..size in cents, the last is the period
+		uint8_t scale_size_;
+		KeyboardMap map_;
+
+		float note_cents_[kNumNotes];
+		uint32_t mapped_[4];
+};
+
+}  // namespace brain::utils
+
+#endif
@@ -2,10 +2,8 @@
 
 namespace brain::utils {
 
-MidiToCV* MidiToCV::instance_ = nullptr;
-
-bool MidiToCV::init(brain::io::AudioCvOutChannel cv_channel, uint8_t midi_channel) {
-	instance_ = this;
+bool MidiToCV::init(brain::io::AudioCvOutChannel cv_channel, uint8_t midi_channel,
+	uart_inst_t* uart, uint8_t rx_gpio) {
 	midi_channel_ = midi_channel;
 
 	// Set default mode
@@ -36,11 +34,21 @@ bool MidiToCV::init(brain::io::AudioCvOutChannel cv_channel, uint8_t midi_channe
 	// Set MIDI parser stuff
 	midi_parser_.set_channel(midi_channel_);
 
-	midi_parser_.set_note_on_callback(note_on_callback);
-	midi_parser_.set_note_off_callback(note_off_callback);
-	midi_parser_.set_control_change_callback(control_change_callback);
-
-	if (!midi_parser_.init_uart()) {
+	// Parser events go straight to this instance
+	midi_parser_.set_note_on_callback([this](uint8_t note, uint8_t velocity, uint8_t channel) {
+		note_on(note, velocity, channel);
+	});
+	midi_parser_.set_note_off_callback([this](uint8_t note, uint8_t velocity, uint8_t channel) {
+		note_off(note, velocity, channel);
+	});
+	midi_parser_.set_control_change_callback([this](uint8_t cc, uint8_t value, uint8_t channel) {
+		control_change(cc, value, channel);
+	});
+	midi_parser_.set_pitch_bend_callback([this](int16_t value, uint8_t channel) {
+		pitch_bend(value, channel);
+	});
+
+	if (!midi_parser_.init_uart(uart, rx_gpio)) {
 		printf("[ERROR] Brain SDK / Midi to CV: MIDI parser failed to initialize.\n");
 		return false;
 	}
@@ -52,36 +60,82 @@ bool MidiToCV::init(brain::io::AudioCvOutChannel cv_channel, uint8_t midi_channe
 	// Modwheel
 	modwheel_value_ = 0;
 
+	// Pitch bend, centered, RPN selection null
+	bend_value_ = 0;
+	bend_target_ = 0;
+	bend_ = 0;
+	rpn_msb_ = 127;
+	rpn_lsb_ = 127;
+	bend_range_semitones_ = 2;
+	bend_range_cents_ = 0;
+
+	// Pitch table with nominal 1V/octave and 12-TET, also sets the bend scale
+	pitch_scale_ = 1.0f;
+	pitch_offset_ = 0.0f;
+	set_tuning(nullptr);
+
 	// Set up CV
-	max_cc_voltage_ = brain::io::AudioCvOut::kMaxVoltage;
+	set_max_cc_voltage(brain::io::AudioCvOut::kMaxVoltage);
 	set_pitch_channel(cv_channel);
 
+	// Envelope runs on the control tick
+	envelope_.init(brain::constants::kDefaultControlRate);
+	legato_ = false;
+	next_control_tick_us_ = time_us_32();
+
 	return true;
 }
 
 void MidiToCV::set_mode(Mode mode) {
+	if (mode == Mode::kDuo && mode_ != Mode::kDuo) {
+		reset_voices();
+	}
 	mode_ = mode;
+
+	// Restart the control tick so switching modes doesn't trigger a catch-up burst
+	next_control_tick_us_ = time_us_32();
 }
 
 MidiToCV::Mode MidiToCV::get_mode() const {
 	return mode_;
 }
 
-void MidiToCV::note_on_callback(uint8_t note, uint8_t velocity, uint8_t channel) {
-	if (instance_) {
-		instance_->note_on(note, velocity, channel);
+void MidiToCV::set_note_priority(NotePriority priority) {
+	priority_ = priority;
+
+	// Held notes may now select a different note
+	if (cv_enabled_ && !note_stack_.empty()) {
+		set_cv();
 	}
 }
 
-void MidiToCV::note_off_callback(uint8_t note, uint8_t velocity, uint8_t channel) {
-	if (instance_) {
-		instance_->note_off(note, velocity, channel);
-	}
+MidiToCV::NotePriority MidiToCV::get_note_priority() const {
+	return priority_;
 }
 
-void MidiToCV::control_change_callback(uint8_t cc, uint8_t value, uint8_t channel) {
-	if (instance_) {
-		instance_->control_change(cc, value, channel);
+void MidiToCV::set_duo_policy(DuoPolicy policy) {
+	duo_policy_ = policy;
+	reset_voices();
+}
+
+MidiToCV::DuoPolicy MidiToCV::get_duo_policy() const {
+	return duo_policy_;
+}
+
+/**
+ * Held note selected by the priority mode, NoteStack::kNoNote if none.
+ * All lookups come straight from the note stack, no rescan per event.
+ */
+uint8_t MidiToCV::priority_note() const {
+	switch (priority_) {
+		case kPriorityLow:
+			return note_stack_.lowest();
+		case kPriorityHigh:
+			return note_stack_.highest();
+		case kPriorityFirst:
+			return note_stack_.first();
+		default:
+			return note_stack_.last();
 	}
 }
 
@@ -92,17 +146,35 @@ void MidiToCV::note_on(uint8_t note, uint8_t velocity, uint8_t channel) {
 		return;
 	}
 
+	// Keys the tuning leaves out don't play
+	if (!((note_mapped_[note >> 5] >> (note & 31)) & 1u)) {
+		return;
+	}
+
+	bool was_playing = !note_stack_.empty();
+
 	// Push note to the note stack
-	push_note(note, velocity);
+	note_stack_.push(note, velocity);
+
+	if (mode_ == Mode::kDuo) {
+		allocate_voice(note);
+	}
+
+	// With low, high or first priority a new note may not take over
+	bool takes_over = !was_playing || mode_ == Mode::kDuo || priority_note() == note;
 
 	// Convert MIDI note to voltage
-	if (cv_enabled_) {
+	if (cv_enabled_ && takes_over) {
 		set_cv();
 	}
 
 	// Set gate high
 	set_gate(true);
 
+	if (mode_ == Mode::kEnvelope && takes_over) {
+		envelope_.gate_on(!(legato_ && was_playing));
+	}
+
 	// Callback note on
 	if (note_on_callback_) {
 		note_on_callback_(note, velocity, channel);
@@ -110,14 +182,22 @@ void MidiToCV::note_on(uint8_t note, uint8_t velocity, uint8_t channel) {
 }
 
 void MidiToCV::note_off(uint8_t note, uint8_t velocity, uint8_t channel) {
-	pop_note(note);
+	note_stack_.remove(note);
+
+	if (mode_ == Mode::kDuo) {
+		release_voice(note);
+	}
 
 	if (cv_enabled_) {
 		set_cv();
 	}
 
-	if (current_stack_size_ == 0) {
+	if (note_stack_.empty()) {
 		set_gate(false);
+
+		if (mode_ == Mode::kEnvelope) {
+			envelope_.gate_off();
+		}
 	}
 
 	// Callback note off
@@ -130,8 +210,60 @@ void MidiToCV::control_change(uint8_t cc, uint8_t value, uint8_t channel) {
 	// Modwheel
 	if (cc == 1 && mode_ == Mode::kModWheel) {
 		modwheel_value_ = value;
-		set_cc_cv(midi_value_to_voltage(modwheel_value_));
+		set_cc_dac(cc_table_[modwheel_value_]);
+	}
+
+	// RPN select, then data entry; RPN 0 is pitch bend sensitivity
+	switch (cc) {
+		case 101:
+			rpn_msb_ = value;
+			break;
+		case 100:
+			rpn_lsb_ = value;
+			break;
+		case 6:
+			if (rpn_msb_ == 0 && rpn_lsb_ == 0) {
+				set_pitch_bend_range(value, 0);
+			}
+			break;
+		case 38:
+			if (rpn_msb_ == 0 && rpn_lsb_ == 0) {
+				set_pitch_bend_range(bend_range_semitones_, value);
+			}
+			break;
+		default:
+			break;
 	}
+
+	// Callback control change
+	if (control_change_callback_) {
+		control_change_callback_(cc, value, channel);
+	}
+}
+
+/**
+ * One multiply per event: the bend target is in DAC codes Q8 and the pitch
+ * CV follows it at the control tick. The product takes 64 bits, a calibrated
+ * pitch scale can push a wide range past 32.
+ */
+void MidiToCV::pitch_bend(int16_t value, uint8_t channel) {
+	bend_value_ = value;
+	bend_target_ = static_cast<int32_t>((static_cast<int64_t>(value) * bend_scale_) >> 13);
+}
+
+void MidiToCV::set_pitch_bend_range(uint8_t semitones, uint8_t cents) {
+	if (semitones > kMaxPitchBendRange) semitones = kMaxPitchBendRange;
+	if (cents > 99) cents = 99;
+	bend_range_semitones_ = semitones;
+	bend_range_cents_ = cents;
+
+	uint32_t range_cents = semitones * 100u + cents;
+	bend_scale_ = static_cast<int32_t>((range_cents * semitone_q8_ + 50) / 100);
+	bend_target_ = static_cast<int32_t>((static_cast<int64_t>(bend_value_) * bend_scale_) >> 13);
+}
+
+uint8_t MidiToCV::get_pitch_bend_range() const {
+	return bend_range_semitones_;
 }
 
 void MidiToCV::set_note_on_callback(NoteOnCallback callback) {
@@ -142,6 +274,10 @@ void MidiToCV::set_note_off_callback(NoteOffCallback callback) {
 	note_off_callback_ = callback;
 }
 
+void MidiToCV::set_control_change_callback(ControlChangeCallback callback) {
+	control_change_callback_ = callback;
+}
+
 void MidiToCV::set_midi_channel(uint8_t midi_channel) {
 	midi_channel_ = midi_channel;
 	midi_parser_.set_channel(midi_channel_);
@@ -157,96 +293,270 @@ void MidiToCV::set_pitch_channel(brain::io::AudioCvOutChannel cv_channel) {
 
 void MidiToCV::update() {
 	midi_parser_.process_uart();
+	run_control_ticks();
+}
+
+/**
+ * Runs every control tick that has elapsed since the last call, paced by the
+ * hardware timer rather than by how often update() is called. The DAC is
+ * written once with the latest envelope value and pitch bend. If the main
+ * loop stalled for longer than a few ticks the schedule is resynced instead
+ * of catching up.
+ */
+void MidiToCV::run_control_ticks() {
+	uint32_t now = time_us_32();
+	uint8_t ticks = 0;
+	uint16_t value = envelope_.value();
+	int32_t bend = bend_;
+	int32_t target = bend_target_;
+
+	while (static_cast<int32_t>(now - next_control_tick_us_) >= 0) {
+		if (mode_ == Mode::kEnvelope) {
+			value = envelope_.tick();
+		}
+
+		// One-pole glide towards the bend target, snapping once within a step
+		int32_t diff = target - bend;
+		if (diff > -(1 << kBendSmoothShift) && diff < (1 << kBendSmoothShift)) {
+			bend = target;
+		} else {
+			bend += diff >> kBendSmoothShift;
+		}
+
+		next_control_tick_us_ += kControlTickUs;
+
+		if (++ticks >= kMaxCatchUpTicks) {
+			next_control_tick_us_ = now + kControlTickUs;
+			break;
+		}
+	}
+
+	if (ticks == 0) {
+		return;
+	}
+
+	if (mode_ == Mode::kEnvelope) {
+		uint16_t dac_value = (static_cast<uint32_t>(value) * envelope_scale_) >> 12;
+		dac_.set_dac_value(cv_other_channel_, dac_value);
+	}
+
+	if (bend != bend_) {
+		bend_ = bend;
+		if (cv_enabled_) {
+			update_pitch_cv();
+		}
+	}
+}
+
+/**
+ * Note plus pitch bend as a DAC code: a table load and an add. The table
+ * keeps 4 fraction bits so bent pitches round only once.
+ */
+uint16_t MidiToCV::pitch_to_dac(uint8_t note) const {
+	int32_t code = (pitch_table_[note] + (bend_ >> 4) + 8) >> 4;
+	if (code < 0) return 0;
+	return code > brain::io::AudioCvOut::kMaxDacValue ? brain::io::AudioCvOut::kMaxDacValue : code;
+}
+
+void MidiToCV::set_pitch_calibration(float scale, float offset_volts) {
+	pitch_scale_ = scale;
+	pitch_offset_ = offset_volts;
+	build_pitch_table();
+}
+
+void MidiToCV::set_tuning(const Tuning* tuning) {
+	tuning_ = tuning;
+	for (uint8_t note = 0; note < kNumNotes; note++) {
+		bool mapped = tuning_ == nullptr || tuning_->is_mapped(note);
+		if (mapped) {
+			note_mapped_[note >> 5] |= 1u << (note & 31);
+		} else {
+			note_mapped_[note >> 5] &= ~(1u << (note & 31));
+		}
+	}
+	build_pitch_table();
+}
+
+/**
+ * Runs in float once per settings change: 1V/octave from kZeroCVMidiNote,
+ * scaled and offset by the calibration, clamped to the DAC range, in Q4.
+ * With a tuning, each note's pitch comes from its table in cents.
+ */
+void MidiToCV::build_pitch_table() {
+	constexpr float kCodesPerVolt =
+		brain::io::AudioCvOut::kMaxDacValue / brain::io::AudioCvOut::kMaxVoltage;
+	constexpr float kMaxCode = brain::io::AudioCvOut::kMaxDacValue << 4;
+
+	for (uint8_t note = 0; note < kNumNotes; note++) {
+		float semitones = tuning_ ? tuning_->get_note_cents(note) / 100.0f : note;
+		float volts = (semitones - kZeroCVMidiNote) / 12.0f * pitch_scale_ + pitch_offset_;
+		float code = volts * kCodesPerVolt * 16.0f + 0.5f;
+		if (code < 0.0f) code = 0.0f;
+		if (code > kMaxCode) code = kMaxCode;
+		pitch_table_[note] = static_cast<uint16_t>(code);
+	}
+
+	// Pitch bend follows the calibrated semitone size
+	semitone_q8_ = static_cast<int32_t>(kCodesPerVolt / 12.0f * pitch_scale_ * 256.0f + 0.5f);
+	set_pitch_bend_range(bend_range_semitones_, bend_range_cents_);
+}
+
+/**
+ * Rewrite only the pitch outputs, for pitch bend changes
+ */
+void MidiToCV::update_pitch_cv() {
+	switch (mode_) {
+		case kDuo:
+			set_duo_cv();
+			break;
+
+		case kUnison: {
+			uint16_t pitch = pitch_to_dac(last_note_.note);
+			dac_.set_dac_values(pitch, pitch);
+			break;
+		}
+
+		default:
+			dac_.set_dac_value(cv_channel_, pitch_to_dac(last_note_.note));
+			break;
+	}
 }
 
 bool MidiToCV::is_note_playing() {
 	return gate_on_;
 }
 
-void MidiToCV::push_note(uint8_t note, uint8_t velocity) {
-	if (find_note(note) != -1) return;
+void MidiToCV::reset_note_stack() {
+	note_stack_.reset();
+	reset_voices();
+}
 
-	// Push the new note in the stack
-	if (current_stack_size_ < kNoteStackSize) {
-		note_stack_[current_stack_size_] = {note, velocity};
-		current_stack_size_++;
+void MidiToCV::reset_voices() {
+	for (uint8_t v = 0; v < kNumVoices; v++) {
+		voice_note_[v] = NoteStack::kNoNote;
+		voice_pitch_[v] = kZeroCVMidiNote;
 	}
+	last_voice_ = kNumVoices - 1;
 }
 
-void MidiToCV::pop_note(uint8_t note) {
-	int note_index = find_note(note);
-	if (note_index == -1) return;
+/**
+ * Give a new note a voice in O(1): a free voice if there is one (preferring
+ * the one after the last assigned, or in kDuoReuse the one that last played
+ * this note), otherwise steal the older of the two assignments.
+ */
+void MidiToCV::allocate_voice(uint8_t note) {
+	if (duo_policy_ == kDuoSplit) {
+		return;
+	}
+
+	uint8_t voice = kNumVoices;
+	for (uint8_t v = 0; v < kNumVoices; v++) {
+		// Retriggered note keeps its voice
+		if (voice_note_[v] == note) {
+			last_voice_ = v;
+			return;
+		}
+		if (duo_policy_ == kDuoReuse && voice_note_[v] == NoteStack::kNoNote &&
+			voice_pitch_[v] == note) {
+			voice = v;
+		}
+	}
 
-	for (size_t i = note_index; i < current_stack_size_ - 1; i++) {
-		note_stack_[i] = note_stack_[i + 1];
+	if (voice == kNumVoices) {
+		uint8_t next = last_voice_ ^ 1;
+		if (voice_note_[next] != NoteStack::kNoNote &&
+			voice_note_[last_voice_] == NoteStack::kNoNote) {
+			voice = last_voice_;
+		} else {
+			voice = next;  // Free, or the older assignment when both sound
+		}
 	}
 
-	note_stack_[current_stack_size_ - 1] = {255, 0};
-	current_stack_size_--;
+	voice_note_[voice] = note;
+	voice_pitch_[voice] = note;
+	last_voice_ = voice;
 }
 
 /**
- * Return -1 if note can't be found
+ * Free the voice of a released note and hand it to the most recent held note
+ * that lost its voice to stealing. Only one other note can hold a voice, so
+ * the walk down the press order stops after at most two steps.
  */
-int MidiToCV::find_note(uint8_t note) {
-	for (size_t i = 0; i < kNoteStackSize; i++) {
-		if (note_stack_[i].note == note) {
-			return i;
+void MidiToCV::release_voice(uint8_t note) {
+	if (duo_policy_ == kDuoSplit) {
+		return;
+	}
+
+	for (uint8_t v = 0; v < kNumVoices; v++) {
+		if (voice_note_[v] != note) {
+			continue;
 		}
-		if (note_stack_[i].note == 255) {
-			return -1;
+
+		voice_note_[v] = NoteStack::kNoNote;
+		for (uint8_t n = note_stack_.last(); n != NoteStack::kNoNote; n = note_stack_.older(n)) {
+			if (n != voice_note_[v ^ 1]) {
+				voice_note_[v] = n;
+				voice_pitch_[v] = n;
+				break;
+			}
 		}
+		return;
 	}
-	return -1;
 }
 
-void MidiToCV::reset_note_stack() {
-	current_stack_size_ = 0;
-	for (size_t i = 0; i < kNoteStackSize; i++) {
-		// Use 255 as default value for each note in the stack because MIDI notes go up only until 127
-		note_stack_[i] = {255, 0};
+void MidiToCV::set_duo_cv() {
+	if (duo_policy_ == kDuoSplit && !note_stack_.empty()) {
+		voice_pitch_[0] = note_stack_.lowest();
+		voice_pitch_[1] = note_stack_.highest();
+	}
+
+	uint16_t pitch_first = pitch_to_dac(voice_pitch_[0]);
+	uint16_t pitch_second = pitch_to_dac(voice_pitch_[1]);
+
+	// Both pitches in one paired DAC write so the voices move together
+	if (cv_channel_ == brain::io::AudioCvOutChannel::kChannelA) {
+		dac_.set_dac_values(pitch_first, pitch_second);
+	} else {
+		dac_.set_dac_values(pitch_second, pitch_first);
 	}
 }
 
 void MidiToCV::set_cv() {
+	if (mode_ == Mode::kDuo) {
+		set_duo_cv();
+		return;
+	}
+
 	NoteVelocity play_note;
 
 	// Keep last note on the CV output even after releasing all keys
-	if (current_stack_size_ > 0) {
-		play_note = note_stack_[current_stack_size_ - 1];
+	if (!note_stack_.empty()) {
+		uint8_t note = priority_note();
+		play_note = {note, note_stack_.velocity(note)};
 		last_note_ = play_note;
 	} else {
 		play_note = last_note_;
 	}
 
-	float note_voltage = (play_note.note - kZeroCVMidiNote) / 12.0f;
-	dac_.set_voltage(cv_channel_, note_voltage);
-
-	float cc_voltage;
-
-	switch (mode_) {
-		case kUnison: {
-			cc_voltage = note_voltage;
-			break;
-		}
+	// Unison writes the pitch to both channels in one paired write
+	if (mode_ == Mode::kUnison) {
+		update_pitch_cv();
+		return;
+	}
 
-		case kModWheel: {
-			cc_voltage = midi_value_to_voltage(modwheel_value_);
-			break;
-		}
+	dac_.set_dac_value(cv_channel_, pitch_to_dac(play_note.note));
 
-		default: {
-			cc_voltage = midi_value_to_voltage(play_note.velocity);
-			break;
-		}
+	// The envelope owns the other channel and is written from the control tick
+	if (mode_ == Mode::kEnvelope) {
+		return;
 	}
 
-	set_cc_cv(cc_voltage);
+	uint8_t cc_value = mode_ == kModWheel ? modwheel_value_ : play_note.velocity;
+	set_cc_dac(cc_table_[cc_value & 0x7F]);
 }
 
-void MidiToCV::set_cc_cv(float cc_voltage) {
-	// Handling modes
-	dac_.set_voltage(cv_other_channel_, cc_voltage);
+void MidiToCV::set_cc_dac(uint16_t dac_value) {
+	dac_.set_dac_value(cv_other_channel_, dac_value);
 }
 
 void MidiToCV::set_gate(bool state) {
@@ -264,10 +574,29 @@ void MidiToCV::disable_cv() {
 
 void MidiToCV::set_max_cc_voltage(uint8_t max_voltage) {
 	max_cc_voltage_ = clamp(0, brain::io::AudioCvOut::kMaxDacValue, max_voltage);
+
+	// Envelope output (0-4095) to DAC value for max_cc_voltage_, as Q12
+	float scale = max_cc_voltage_ / brain::io::AudioCvOut::kMaxVoltage;
+	if (scale > 1.0f) scale = 1.0f;
+	envelope_scale_ = static_cast<uint16_t>(scale * 4096.0f);
+
+	// Velocity and CC values 0-127 to DAC codes for 0 to max_cc_voltage_
+	for (uint8_t value = 0; value < kNumNotes; value++) {
+		float code = value * scale * brain::io::AudioCvOut::kMaxDacValue / 127.0f + 0.5f;
+		cc_table_[value] = static_cast<uint16_t>(code);
+	}
+}
+
+Envelope& MidiToCV::envelope() {
+	return envelope_;
+}
+
+void MidiToCV::set_legato(bool legato) {
+	legato_ = legato;
 }
 
-float MidiToCV::midi_value_to_voltage(uint8_t value) {
-	return value * max_cc_voltage_ / 127.0;
+bool MidiToCV::get_legato() const {
+	return legato_;
 }
 
 }
\ No newline at end of file
@@ -0,0 +1,123 @@
+#include "brain-utils/note-stack.h"
+
+namespace brain::utils {
+
+NoteStack::NoteStack() {
+	reset();
+}
+
+void NoteStack::reset() {
+	for (uint8_t w = 0; w < 4; w++) {
+		bits_[w] = 0;
+	}
+	head_ = kNoNote;
+	tail_ = kNoNote;
+	size_ = 0;
+}
+
+bool NoteStack::push(uint8_t note, uint8_t velocity) {
+	if (note >= kNumNotes) {
+		return false;
+	}
+
+	if (contains(note)) {
+		unlink(note);
+	} else {
+		bits_[note >> 5] |= 1u << (note & 31);
+		size_++;
+	}
+
+	velocity_[note] = velocity;
+	prev_[note] = tail_;
+	next_[note] = kNoNote;
+	if (tail_ != kNoNote) {
+		next_[tail_] = note;
+	} else {
+		head_ = note;
+	}
+	tail_ = note;
+	return true;
+}
+
+bool NoteStack::remove(uint8_t note) {
+	if (!contains(note)) {
+		return false;
+	}
+
+	unlink(note);
+	bits_[note >> 5] &= ~(1u << (note & 31));
+	size_--;
+	return true;
+}
+
+void NoteStack::unlink(uint8_t note) {
+	uint8_t prev = prev_[note];
+	uint8_t next = next_[note];
+
+	if (prev != kNoNote) {
+		next_[prev] = next;
+	} else {
+		head_ = next;
+	}
+
+	if (next != kNoNote) {
+		prev_[next] = prev;
+	} else {
+		tail_ = prev;
+	}
+}
+
+bool NoteStack::contains(uint8_t note) const {
+	if (note >= kNumNotes) {
+		return false;
+	}
+	return (bits_[note >> 5] >> (note & 31)) & 1u;
+}
+
+uint8_t NoteStack::size() const {
+	return size_;
+}
+
+bool NoteStack::empty() const {
+	return size_ == 0;
+}
+
+uint8_t NoteStack::velocity(uint8_t note) const {
+	return contains(note) ? velocity_[note] : 0;
+}
+
+uint8_t NoteStack::last() const {
+	return tail_;
+}
+
+uint8_t NoteStack::first() const {
+	return head_;
+}
+
+uint8_t NoteStack::lowest() const {
+	for (uint8_t w = 0; w < 4; w++) {
+		if (bits_[w] != 0) {
+			return (w << 5) + __builtin_ctz(bits_[w]);
+		}
+	}
+	return kNoNote;
+}
+
+uint8_t NoteStack::highest() const {
+	for (int8_t w = 3; w >= 0; w--) {
+		if (bits_[w] != 0) {
+			return (w << 5) + 31 - __builtin_clz(bits_[w]);
+		}
+	}
+	return kNoNote;
+}
+
+uint8_t NoteStack::older(uint8_t note) const {
+	return contains(note) ? prev_[note] : kNoNote;
+}
+
+uint8_t NoteStack::newer(uint8_t note) const {
+	return contains(note) ? next_[note] : kNoNote;
+}
+
+}  // namespace brain::utils
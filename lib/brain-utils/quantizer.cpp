@@ -0,0 +1,188 @@
+#include "brain-utils/quantizer.h"
+
+#include <hardware/sync.h>
+
+#include <cstdio>
+
+namespace brain::utils {
+
+bool Quantizer::init(brain::io::AudioCvIn* input, int input_channel,
+	brain::io::AudioCvOut* output, brain::io::AudioCvOutChannel output_channel,
+	brain::io::Pulse* pulse) {
+	if (input == nullptr || output == nullptr) {
+		fprintf(stderr, "Quantizer: Input and output are required\n");
+		return false;
+	}
+	if (input_channel != brain::io::AudioCvInChannel::kChannelA &&
+		input_channel != brain::io::AudioCvInChannel::kChannelB) {
+		fprintf(stderr, "Quantizer: Invalid input channel %d\n", input_channel);
+		return false;
+	}
+
+	input_ = input;
+	input_channel_ = input_channel;
+	output_ = output;
+	output_channel_ = output_channel;
+	pulse_ = pulse;
+
+	set_scale(kChromatic, 0);
+	return true;
+}
+
+bool Quantizer::start(uint32_t sample_rate_hz) {
+	if (input_ == nullptr) {
+		return false;
+	}
+
+	return input_->start_stream(sample_rate_hz,
+		[this](const uint16_t* a, const uint16_t* b, size_t n) { process_block(a, b, n); });
+}
+
+void Quantizer::stop() {
+	if (input_ != nullptr) {
+		input_->stop_stream();
+	}
+}
+
+bool Quantizer::set_scale(uint16_t mask, uint8_t root) {
+	if ((mask & kChromatic) == 0 || root > 11) {
+		return false;
+	}
+
+	mask_ = mask & kChromatic;
+	root_ = root;
+	build_table();
+	return true;
+}
+
+uint16_t Quantizer::get_scale() const {
+	return mask_;
+}
+
+uint8_t Quantizer::get_root() const {
+	return root_;
+}
+
+void Quantizer::set_hysteresis_mv(int32_t millivolts) {
+	hysteresis_mv_ = millivolts > 0 ? millivolts : 0;
+}
+
+void Quantizer::set_output_octave(int8_t octaves) {
+	if (octaves < -5) octaves = -5;
+	if (octaves > 10) octaves = 10;
+	output_octave_ = octaves;
+	build_table();
+}
+
+void Quantizer::set_trigger_width_us(uint32_t width_us) {
+	trigger_width_us_ = width_us;
+}
+
+void Quantizer::process_block(const uint16_t* a, const uint16_t* b, size_t n) {
+	const uint16_t* samples = input_channel_ == brain::io::AudioCvInChannel::kChannelA ? a : b;
+	if (input_ == nullptr || samples == nullptr || n == 0) {
+		return;
+	}
+
+	// Averaging the block takes the ADC noise down before the thresholds
+	uint32_t sum = 0;
+	for (size_t i = 0; i < n; i++) {
+		sum += samples[i];
+	}
+	uint16_t mean = static_cast<uint16_t>((sum + n / 2) / n);
+
+	process_mv(input_->raw_to_millivolts(input_channel_, mean));
+}
+
+void Quantizer::process_mv(int32_t millivolts) {
+	if (output_ == nullptr) {
+		return;
+	}
+
+	// Stay on the current pitch while the input is inside its widened window
+	uint8_t index = index_;
+	if (index_valid_) {
+		bool below = index > 0 && millivolts < table_.threshold_mv[index] - hysteresis_mv_;
+		bool above = index + 1 < table_.size &&
+			millivolts >= table_.threshold_mv[index + 1] + hysteresis_mv_;
+		if (!below && !above) {
+			return;
+		}
+	}
+
+	index = search(millivolts);
+	index_ = index;
+	index_valid_ = true;
+
+	uint16_t dac_code = table_.dac_code[index];
+	if (has_output_ && dac_code == dac_code_) {
+		return;
+	}
+	output_->set_dac_value(output_channel_, dac_code);
+	dac_code_ = dac_code;
+
+	// A new scale or octave can move the output without a new pitch
+	int8_t semitone = table_.semitone[index];
+	bool retrigger = has_output_ && semitone != semitone_;
+	semitone_ = semitone;
+	has_output_ = true;
+	if (retrigger && pulse_ != nullptr && trigger_width_us_ > 0) {
+		pulse_->trigger(trigger_width_us_);
+	}
+}
+
+int8_t Quantizer::get_semitone() const {
+	return semitone_;
+}
+
+/**
+ * Thresholds sit halfway between neighbouring allowed pitches. Built aside
+ * and swapped in with interrupts disabled, so the stream interrupt never sees
+ * a half-written table. The next input value then does a full search.
+ */
+void Quantizer::build_table() {
+	constexpr float kCodesPerSemitone =
+		brain::io::AudioCvOut::kMaxDacValue / brain::io::AudioCvOut::kMaxVoltage / 12.0f;
+
+	Table table;
+	table.size = 0;
+	for (int16_t semitone = kMinSemitone; semitone <= kMaxSemitone; semitone++) {
+		uint8_t degree = static_cast<uint8_t>((semitone - root_ + 120) % 12);
+		if (!((mask_ >> degree) & 1u)) {
+			continue;
+		}
+
+		uint8_t i = table.size++;
+		table.semitone[i] = static_cast<int8_t>(semitone);
+		table.threshold_mv[i] =
+			i == 0 ? kMinSemitone * 1000 / 12 : (table.semitone[i - 1] + semitone) * 1000 / 24;
+
+		float code = (semitone + output_octave_ * 12) * kCodesPerSemitone + 0.5f;
+		if (code < 0.0f) code = 0.0f;
+		if (code > brain::io::AudioCvOut::kMaxDacValue) code = brain::io::AudioCvOut::kMaxDacValue;
+		table.dac_code[i] = static_cast<uint16_t>(code);
+	}
+
+	uint32_t irq_state = save_and_disable_interrupts();
+	table_ = table;
+	index_ = 0;
+	index_valid_ = false;
+	restore_interrupts(irq_state);
+}
+
+uint8_t Quantizer::search(int32_t millivolts) const {
+	// Last pitch whose lower threshold is at or below the input
+	uint8_t low = 0;
+	uint8_t high = table_.size - 1;
+	while (low < high) {
+		uint8_t mid = (low + high + 1) / 2;
+		if (table_.threshold_mv[mid] <= millivolts) {
+			low = mid;
+		} else {
+			high = mid - 1;
+		}
+	}
+	return low;
+}
+
+}  // namespace brain::utils
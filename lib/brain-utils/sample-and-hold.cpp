@@ -0,0 +1,126 @@
+#include "brain-utils/sample-and-hold.h"
+
+#include <hardware/sync.h>
+
+#include <cstdio>
+
+namespace brain::utils {
+
+namespace {
+
+// DAC codes per millivolt in Q16: 4095 / 10000 mV
+constexpr int32_t kDacPerMvQ16 = 26837;
+
+}  // namespace
+
+bool SampleAndHold::init(brain::io::AudioCvIn* input, int input_channel,
+	brain::io::AudioCvOut* output, brain::io::AudioCvOutChannel output_channel,
+	brain::io::Pulse* pulse) {
+	if (input == nullptr || output == nullptr || pulse == nullptr) {
+		fprintf(stderr, "SampleAndHold: Input, output and pulse are required\n");
+		return false;
+	}
+	if (input_channel != brain::io::AudioCvInChannel::kChannelA &&
+		input_channel != brain::io::AudioCvInChannel::kChannelB) {
+		fprintf(stderr, "SampleAndHold: Invalid input channel %d\n", input_channel);
+		return false;
+	}
+
+	input_ = input;
+	input_channel_ = input_channel;
+	output_ = output;
+	output_channel_ = output_channel;
+	pulse_ = pulse;
+
+	pulse_->on_edge_irq([this](bool rising, uint32_t time_us) { handle_edge(rising, time_us); });
+	pulse_->enable_interrupts();
+
+	return true;
+}
+
+void SampleAndHold::set_mode(Mode mode) {
+	mode_ = mode;
+	tracking_ = mode_ == kTrackAndHold && pulse_ != nullptr && pulse_->read();
+}
+
+SampleAndHold::Mode SampleAndHold::get_mode() const {
+	return mode_;
+}
+
+void SampleAndHold::set_output_offset_mv(int32_t millivolts) {
+	if (millivolts < -10000) millivolts = -10000;
+	if (millivolts > 10000) millivolts = 10000;
+	offset_mv_ = millivolts;
+}
+
+void SampleAndHold::update() {
+	if (!tracking_) {
+		return;
+	}
+
+	// Sample with interrupts on, an edge in the meantime takes its own sample
+	uint32_t samples = sample_count_;
+	int32_t mv = input_->raw_to_millivolts(input_channel_, input_->sample_raw(input_channel_));
+	uint16_t code = to_dac_code(mv);
+
+	uint32_t irq_state = save_and_disable_interrupts();
+	bool current = tracking_ && sample_count_ == samples;
+	if (current) {
+		held_mv_ = mv;
+	}
+	restore_interrupts(irq_state);
+	if (!current) {
+		return;
+	}
+
+	output_->set_dac_value(output_channel_, code);
+
+	// An edge between the check and the write held a newer value, put it back
+	if (sample_count_ != samples) {
+		output_->set_dac_value(output_channel_, held_code_);
+	}
+}
+
+int32_t SampleAndHold::get_held_mv() const {
+	return held_mv_;
+}
+
+uint32_t SampleAndHold::get_sample_time_us() const {
+	return sample_time_us_;
+}
+
+/**
+ * Runs in the GPIO interrupt. In track mode the rising edge only starts
+ * following, the falling edge takes the sample that is held.
+ */
+void SampleAndHold::handle_edge(bool rising, uint32_t time_us) {
+	if (mode_ == kTrackAndHold) {
+		tracking_ = rising;
+		if (rising) {
+			sample();
+			return;
+		}
+	} else if (!rising) {
+		return;
+	}
+
+	sample();
+	sample_time_us_ = time_us;
+}
+
+void SampleAndHold::sample() {
+	int32_t mv = input_->raw_to_millivolts(input_channel_, input_->sample_raw(input_channel_));
+	held_mv_ = mv;
+	held_code_ = to_dac_code(mv);
+	sample_count_ = sample_count_ + 1;
+	output_->set_dac_value(output_channel_, held_code_);
+}
+
+uint16_t SampleAndHold::to_dac_code(int32_t millivolts) const {
+	int32_t code = ((millivolts + offset_mv_) * kDacPerMvQ16 + (1 << 15)) >> 16;
+	if (code < 0) code = 0;
+	if (code > brain::io::AudioCvOut::kMaxDacValue) code = brain::io::AudioCvOut::kMaxDacValue;
+	return static_cast<uint16_t>(code);
+}
+
+}  // namespace brain::utils
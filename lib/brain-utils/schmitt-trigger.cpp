@@ -0,0 +1,43 @@
+#include "brain-utils/schmitt-trigger.h"
+
+namespace brain::utils {
+
+bool SchmittTrigger::set_thresholds(uint16_t low, uint16_t high) {
+	if (low >= high) {
+		return false;
+	}
+
+	low_ = low;
+	high_ = high;
+	return true;
+}
+
+void SchmittTrigger::reset(bool state) {
+	state_ = state;
+}
+
+size_t SchmittTrigger::process(const uint16_t* in, size_t n, Edge* edges, size_t max_edges) {
+	size_t count = 0;
+
+	for (size_t i = 0; i < n; i++) {
+		// Only one comparison per sample, against the threshold for the current state
+		if (state_ ? in[i] > low_ : in[i] < high_) {
+			continue;
+		}
+
+		state_ = !state_;
+		if (count < max_edges) {
+			edges[count].index = static_cast<uint16_t>(i);
+			edges[count].rising = state_;
+			count++;
+		}
+	}
+
+	return count;
+}
+
+bool SchmittTrigger::state() const {
+	return state_;
+}
+
+}  // namespace brain::utils
@@ -0,0 +1,51 @@
+#include "brain-utils/smoothing-filter.h"
+
+namespace brain::utils {
+
+void SmoothingFilter::set_params(uint16_t min_alpha, uint8_t sensitivity_shift, uint16_t deadband) {
+	if (min_alpha == 0) min_alpha = 1;
+	if (min_alpha > kAlphaOne) min_alpha = kAlphaOne;
+
+	min_alpha_ = min_alpha;
+	sensitivity_shift_ = sensitivity_shift;
+	deadband_ = deadband;
+}
+
+void SmoothingFilter::reset(uint16_t value) {
+	if (value > 4095) value = 4095;
+	state_ = static_cast<int32_t>(value) << kStateBits;
+	output_ = value << kFractionBits;
+}
+
+uint16_t SmoothingFilter::process(uint16_t sample) {
+	if (sample > 4095) sample = 4095;
+
+	int32_t error = (static_cast<int32_t>(sample) << kStateBits) - state_;
+	uint32_t magnitude = (error < 0 ? -error : error) >> (kStateBits - kFractionBits);
+
+	// Large steps mean the control is moving, so follow it more closely
+	uint32_t alpha = min_alpha_ + (magnitude >> sensitivity_shift_);
+	if (alpha > kAlphaOne) alpha = kAlphaOne;
+
+	state_ += (error * static_cast<int32_t>(alpha)) / kAlphaOne;
+
+	// Snap to the ends so both extremes stay reachable despite the deadband
+	int32_t target = state_ >> (kStateBits - kFractionBits);
+	if (target <= deadband_) {
+		output_ = 0;
+	} else if (target >= kMaxValue - deadband_) {
+		output_ = kMaxValue;
+	} else if (target > output_ + deadband_) {
+		output_ = static_cast<uint16_t>(target - deadband_);
+	} else if (target + deadband_ < output_) {
+		output_ = static_cast<uint16_t>(target + deadband_);
+	}
+
+	return output_;
+}
+
+uint16_t SmoothingFilter::value() const {
+	return output_;
+}
+
+}  // namespace brain::utils
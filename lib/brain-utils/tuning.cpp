@@ -0,0 +1,338 @@
+#include "brain-utils/tuning.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace brain::utils {
+
+namespace {
+
+constexpr size_t kMaxLine = 96;
+constexpr uint8_t kDefaultMiddleNote = 60;
+constexpr float kMiddleCHz = 261.625565f;
+
+// Copy the next line that isn't a comment into line, without the line break
+bool next_line(const char*& pos, const char* end, char* line) {
+	while (pos < end) {
+		size_t n = 0;
+		while (pos < end && *pos != '\n') {
+			if (*pos != '\r' && n < kMaxLine - 1) {
+				line[n++] = *pos;
+			}
+			pos++;
+		}
+		if (pos < end) {
+			pos++;
+		}
+		line[n] = '\0';
+
+		if (line[0] != '!') {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool parse_int(const char* s, long& value) {
+	char* parse_end;
+	value = strtol(s, &parse_end, 10);
+	return parse_end != s;
+}
+
+// Scala pitch: cents if it has a period, otherwise a ratio "n/d" or integer "n"
+bool parse_pitch(const char* s, float& cents) {
+	while (*s == ' ' || *s == '\t') {
+		s++;
+	}
+
+	bool is_cents = false;
+	for (const char* p = s; *p != '\0' && *p != ' ' && *p != '\t'; p++) {
+		if (*p == '.') {
+			is_cents = true;
+		}
+	}
+
+	char* parse_end;
+	if (is_cents) {
+		cents = strtof(s, &parse_end);
+		return parse_end != s;
+	}
+
+	long num = strtol(s, &parse_end, 10);
+	if (parse_end == s || num <= 0) {
+		return false;
+	}
+
+	long den = 1;
+	if (*parse_end == '/') {
+		const char* den_start = parse_end + 1;
+		den = strtol(den_start, &parse_end, 10);
+		if (parse_end == den_start || den <= 0) {
+			return false;
+		}
+	}
+
+	cents = static_cast<float>(1200.0 * std::log2(static_cast<double>(num) / den));
+	return true;
+}
+
+// Pitch of a scale degree relative to degree 0, repeating every period
+float degree_cents(const float* scale, uint8_t scale_size, int32_t degree) {
+	int32_t periods = degree / scale_size;
+	int32_t step = degree % scale_size;
+	if (step < 0) {
+		step += scale_size;
+		periods--;
+	}
+
+	float cents = periods * scale[scale_size - 1];
+	if (step > 0) {
+		cents += scale[step - 1];
+	}
+	return cents;
+}
+
+}  // namespace
+
+Tuning::Tuning() {
+	set_equal_temperament();
+}
+
+void Tuning::set_equal_temperament() {
+	for (uint8_t i = 0; i < 12; i++) {
+		scale_[i] = (i + 1) * 100.0f;
+	}
+	scale_size_ = 12;
+	default_map(map_);
+	build_table(scale_, scale_size_, map_);
+}
+
+void Tuning::default_map(KeyboardMap& map) {
+	map.size = 0;
+	map.first_note = 0;
+	map.last_note = kNumNotes - 1;
+	map.middle_note = kDefaultMiddleNote;
+	map.reference_note = kDefaultMiddleNote;
+	map.reference_hz = kMiddleCHz;
+	map.octave_degree = 0;
+}
+
+bool Tuning::load_scl(const char* text, size_t length) {
+	const char* pos = text;
+	const char* end = text + length;
+	char line[kMaxLine];
+
+	// Description line, may be empty
+	if (text == nullptr || !next_line(pos, end, line)) {
+		fprintf(stderr, "Tuning: Empty scale file\n");
+		return false;
+	}
+
+	long count = 0;
+	if (!next_line(pos, end, line) || !parse_int(line, count) || count < 1 ||
+		count > kMaxScaleSize) {
+		fprintf(stderr, "Tuning: Invalid scale size\n");
+		return false;
+	}
+
+	float scale[kMaxScaleSize];
+	for (long i = 0; i < count; i++) {
+		if (!next_line(pos, end, line) || !parse_pitch(line, scale[i])) {
+			fprintf(stderr, "Tuning: Invalid pitch for degree %ld\n", i + 1);
+			return false;
+		}
+	}
+
+	if (scale[count - 1] <= 0.0f) {
+		fprintf(stderr, "Tuning: Scale period must be above unison\n");
+		return false;
+	}
+
+	if (!build_table(scale, static_cast<uint8_t>(count), map_)) {
+		return false;
+	}
+
+	for (long i = 0; i < count; i++) {
+		scale_[i] = scale[i];
+	}
+	scale_size_ = static_cast<uint8_t>(count);
+	return true;
+}
+
+bool Tuning::load_kbm(const char* text, size_t length) {
+	const char* pos = text;
+	const char* end = text + length;
+	char line[kMaxLine];
+	long fields[5];
+
+	if (text == nullptr) {
+		fprintf(stderr, "Tuning: Empty keyboard map\n");
+		return false;
+	}
+
+	// Map size, first note, last note, middle note, reference note
+	for (uint8_t i = 0; i < 5; i++) {
+		if (!next_line(pos, end, line) || !parse_int(line, fields[i])) {
+			fprintf(stderr, "Tuning: Keyboard map header incomplete\n");
+			return false;
+		}
+	}
+
+	if (fields[0] < 0 || fields[0] > kMaxMapSize) {
+		fprintf(stderr, "Tuning: Invalid keyboard map size\n");
+		return false;
+	}
+	for (uint8_t i = 1; i < 5; i++) {
+		if (fields[i] < 0 || fields[i] >= kNumNotes) {
+			fprintf(stderr, "Tuning: Keyboard map note out of range\n");
+			return false;
+		}
+	}
+	if (fields[1] > fields[2]) {
+		fprintf(stderr, "Tuning: First note above last note\n");
+		return false;
+	}
+
+	KeyboardMap map;
+	map.size = static_cast<uint8_t>(fields[0]);
+	map.first_note = static_cast<uint8_t>(fields[1]);
+	map.last_note = static_cast<uint8_t>(fields[2]);
+	map.middle_note = static_cast<uint8_t>(fields[3]);
+	map.reference_note = static_cast<uint8_t>(fields[4]);
+
+	char* parse_end;
+	if (!next_line(pos, end, line)) {
+		fprintf(stderr, "Tuning: Keyboard map header incomplete\n");
+		return false;
+	}
+	map.reference_hz = strtof(line, &parse_end);
+	if (parse_end == line || map.reference_hz <= 0.0f) {
+		fprintf(stderr, "Tuning: Invalid reference frequency\n");
+		return false;
+	}
+
+	long octave_degree = 0;
+	if (!next_line(pos, end, line) || !parse_int(line, octave_degree) || octave_degree < 0 ||
+		octave_degree > kMaxScaleSize) {
+		fprintf(stderr, "Tuning: Invalid formal octave degree\n");
+		return false;
+	}
+	map.octave_degree = static_cast<uint8_t>(octave_degree);
+
+	// Missing entries at the end leave their keys unmapped
+	for (uint8_t i = 0; i < map.size; i++) {
+		long degree = -1;
+		if (next_line(pos, end, line)) {
+			const char* s = line;
+			while (*s == ' ' || *s == '\t') {
+				s++;
+			}
+			if (*s != 'x' && *s != 'X' && (!parse_int(s, degree) || degree < 0 || degree > 127)) {
+				fprintf(stderr, "Tuning: Invalid keyboard map entry %u\n", i);
+				return false;
+			}
+		}
+		map.map[i] = static_cast<int8_t>(degree);
+	}
+
+	if (!build_table(scale_, scale_size_, map)) {
+		return false;
+	}
+
+	map_ = map;
+	return true;
+}
+
+void Tuning::reset_keyboard_map() {
+	default_map(map_);
+	build_table(scale_, scale_size_, map_);
+}
+
+bool Tuning::set_note_cents(uint8_t note, float cents) {
+	if (note >= kNumNotes) {
+		return false;
+	}
+
+	note_cents_[note] = cents;
+	mapped_[note >> 5] |= 1u << (note & 31);
+	return true;
+}
+
+float Tuning::get_note_cents(uint8_t note) const {
+	if (note >= kNumNotes) {
+		return 0.0f;
+	}
+	return note_cents_[note];
+}
+
+bool Tuning::is_mapped(uint8_t note) const {
+	if (note >= kNumNotes) {
+		return false;
+	}
+	return (mapped_[note >> 5] >> (note & 31)) & 1u;
+}
+
+uint8_t Tuning::get_scale_size() const {
+	return scale_size_;
+}
+
+bool Tuning::note_degree(const KeyboardMap& map, uint8_t scale_size, uint8_t note,
+	int32_t& degree) {
+	int32_t offset = static_cast<int32_t>(note) - map.middle_note;
+	if (map.size == 0) {
+		degree = offset;
+		return true;
+	}
+
+	int32_t pattern = offset / map.size;
+	int32_t key = offset % map.size;
+	if (key < 0) {
+		key += map.size;
+		pattern--;
+	}
+
+	if (map.map[key] < 0) {
+		return false;
+	}
+
+	uint8_t octave_degree = map.octave_degree != 0 ? map.octave_degree : scale_size;
+	degree = pattern * octave_degree + map.map[key];
+	return true;
+}
+
+/**
+ * Validates first and only then writes, so a failed load keeps the old table.
+ * The reference note gets the reference frequency; every other note is offset
+ * from it by the difference of their scale degrees.
+ */
+bool Tuning::build_table(const float* scale, uint8_t scale_size, const KeyboardMap& map) {
+	int32_t reference_degree;
+	if (!note_degree(map, scale_size, map.reference_note, reference_degree)) {
+		fprintf(stderr, "Tuning: Reference note is not mapped\n");
+		return false;
+	}
+
+	float reference_cents = 6900.0f + 1200.0f * std::log2(map.reference_hz / 440.0f);
+	float base_cents = reference_cents - degree_cents(scale, scale_size, reference_degree);
+
+	for (uint8_t w = 0; w < 4; w++) {
+		mapped_[w] = 0;
+	}
+
+	for (uint8_t note = 0; note < kNumNotes; note++) {
+		int32_t degree;
+		if (note < map.first_note || note > map.last_note ||
+			!note_degree(map, scale_size, note, degree)) {
+			note_cents_[note] = note * 100.0f;
+			continue;
+		}
+
+		note_cents_[note] = base_cents + degree_cents(scale, scale_size, degree);
+		mapped_[note >> 5] |= 1u << (note & 31);
+	}
+
+	return true;
+}
+
+}  // namespace brain::utils
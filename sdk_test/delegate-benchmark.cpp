@@ -0,0 +1,97 @@
+/**
+ * @file delegate-benchmark.cpp
+ * @brief Call and assignment overhead of brain::utils::Delegate against std::function
+ *
+ * Each case runs kIterations times through a non-inlined loop so the compiler
+ * can't see which callable it holds, like a callback stored in a driver.
+ * Results are total microseconds and nanoseconds per iteration.
+ */
+
+#include "delegate-benchmark.h"
+
+#include <stdio.h>
+
+#include <functional>
+
+#include "brain-utils/delegate.h"
+#include "pico/stdlib.h"
+
+namespace {
+
+constexpr uint32_t kIterations = 100000;
+
+volatile uint32_t sink = 0;
+
+struct Captures {
+	uint32_t* a;
+	uint32_t* b;
+	uint32_t* c;
+};
+
+void add_one(void* context, uint32_t v) {
+	*static_cast<uint32_t*>(context) += v;
+}
+
+template <typename Callback>
+__attribute__((noipa)) void call_loop(const Callback& cb, uint32_t iterations) {
+	for (uint32_t i = 0; i < iterations; i++) {
+		cb(i);
+	}
+}
+
+// Captures three pointers: fits the Delegate storage, larger than the
+// small-object buffer of newlib's std::function, which then allocates
+template <typename Callback>
+__attribute__((noipa)) void assign_loop(Callback& cb, const Captures& cap,
+	uint32_t iterations) {
+	for (uint32_t i = 0; i < iterations; i++) {
+		cb = [a = cap.a, b = cap.b, c = cap.c](uint32_t v) { *a += v + *b + *c; };
+	}
+}
+
+void report(const char* name, uint64_t start_us) {
+	uint32_t elapsed = static_cast<uint32_t>(time_us_64() - start_us);
+	printf("  %-28s %7lu us  %5lu ns/iter\n", name, static_cast<unsigned long>(elapsed),
+		static_cast<unsigned long>((static_cast<uint64_t>(elapsed) * 1000) / kIterations));
+}
+
+}  // namespace
+
+void run_delegate_benchmark() {
+	uint32_t counter = 0;
+	uint32_t zero = 0;
+	Captures cap = {&counter, &zero, &zero};
+
+	void (*raw)(void*, uint32_t) = &add_one;
+	std::function<void(uint32_t)> function = [&counter](uint32_t v) { counter += v; };
+	brain::utils::Delegate<void(uint32_t)> delegate = [&counter](uint32_t v) { counter += v; };
+	brain::utils::Delegate<void(uint32_t)> bound(&add_one, &counter);
+
+	printf("Delegate benchmark (%lu iterations):\n", static_cast<unsigned long>(kIterations));
+
+	uint64_t start = time_us_64();
+	call_loop([raw, &counter](uint32_t v) { raw(&counter, v); }, kIterations);
+	report("call function pointer", start);
+
+	start = time_us_64();
+	call_loop(function, kIterations);
+	report("call std::function", start);
+
+	start = time_us_64();
+	call_loop(delegate, kIterations);
+	report("call Delegate (lambda)", start);
+
+	start = time_us_64();
+	call_loop(bound, kIterations);
+	report("call Delegate (context)", start);
+
+	start = time_us_64();
+	assign_loop(function, cap, kIterations);
+	report("assign std::function", start);
+
+	start = time_us_64();
+	assign_loop(delegate, cap, kIterations);
+	report("assign Delegate", start);
+
+	sink = counter;
+}
@@ -0,0 +1,9 @@
+/**
+ * @file delegate-benchmark.h
+ * @brief Call and assignment overhead of brain::utils::Delegate against std::function
+ */
+
+#pragma once
+
+// Runs the benchmark and prints the results over stdio
+void run_delegate_benchmark();
@@ -23,6 +23,8 @@
 #include "brain-ui/led.h"
 #include "brain-ui/pots.h"
 
+#include "delegate-benchmark.h"
+
 int main() {
     // Initialize standard I/O
     stdio_init_all();
@@ -38,6 +40,11 @@ int main() {
     printf("- ADC max value: %u\n", brain::constants::kAdcMaxValue);
     printf("- ADC voltage ref: %.2fV\n", brain::constants::kAdcVoltageRef);
 
+#ifdef BRAIN_SDK_TEST_DELEGATE_BENCHMARK
+    printf("\n");
+    run_delegate_benchmark();
+#endif
+
     printf("\nSDK test program running. Press Ctrl+C to exit.\n");
 
 	brain::utils::MidiToCV midiToCV;